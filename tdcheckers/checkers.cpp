@@ -1,6 +1,7 @@
 #include "checkers.h"
 
 #include <bitset>
+#include <bit>
 #include "global.h"
 
 
@@ -30,6 +31,49 @@ static constexpr uint64_t make_checkers_bitboard(int rowstart, int rowend)
 	return bitboard;
 }
 
+// helper that returns the squares of the board that stay on the board when moved by (rowstep, colstep),
+// used to stop shifted bitboards from wrapping around the edges
+static constexpr uint64_t make_shift_bitboard(int rowstep, int colstep)
+{
+	uint64_t board = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
+	uint64_t bitboard = 0ull;
+
+	for (int i = 0; i < G_CHECKERS_SIZE; ++i)
+	{
+		int row = i / G_CHECKERS_WIDTH + rowstep;
+		int col = i % G_CHECKERS_WIDTH + colstep;
+
+		if ((board & (1ull << i)) == 0)
+			continue;
+
+		if (row < 0 || row >= G_CHECKERS_WIDTH || col < 0 || col >= G_CHECKERS_WIDTH)
+			continue;
+
+		bitboard |= 1ull << i;
+	}
+
+	return bitboard;
+}
+
+// the square index offsets of the four diagonals, backward (towards row 0) first, then forward
+static constexpr int diagonal_shifts[4] = { -(G_CHECKERS_WIDTH + 1), -(G_CHECKERS_WIDTH - 1), (G_CHECKERS_WIDTH - 1), (G_CHECKERS_WIDTH + 1) };
+
+// the squares that can step once along each diagonal
+static constexpr uint64_t diagonal_step_masks[4] = {
+	make_shift_bitboard(-1, -1), make_shift_bitboard(-1, 1), make_shift_bitboard(1, -1), make_shift_bitboard(1, 1)
+};
+
+// the squares that can jump (step twice) along each diagonal
+static constexpr uint64_t diagonal_jump_masks[4] = {
+	make_shift_bitboard(-2, -2), make_shift_bitboard(-2, 2), make_shift_bitboard(2, -2), make_shift_bitboard(2, 2)
+};
+
+// shifts the whole bitboard by the square index offset
+static constexpr uint64_t shift_bitboard(uint64_t bitboard, int shift)
+{
+	return shift < 0 ? bitboard >> (-shift) : bitboard << shift;
+}
+
 
 // returns a string representation of the bitboard
 static std::string bitboard_repr(uint64_t bitboard)
@@ -295,101 +339,148 @@ void checkers::move::add_landing(uint64_t position)
 
 
 
-// compute all the jumps available for the given piece, recursively
-// for the root call:
+// conversion constructor from a move
+checkers::compact_move::compact_move(const move &move)
+	: captures(0ull), path(0ull), length(0)
+{
+	from = std::countr_zero(move.from);
+	to = std::countr_zero(move.to);
+
+	// replay the captures as jumps, the landing is the reflection of the previous landing over the capture
+	int at = from;
+	for (auto cap : move.captures)
+	{
+		int over = std::countr_zero(cap);
+		int landing = 2 * over - at;
+		add_jump(over, landing);
+		at = landing;
+	}
+}
+
+// converts to a move
+checkers::move checkers::compact_move::expand() const
+{
+	move out;
+	out.from = 1ull << from;
+	out.to = 1ull << to;
+
+	// the capture is the midpoint of two consecutive landings
+	int at = from;
+	for (int i = 0; i < length; ++i)
+	{
+		int landing = to;
+		if (i < length - 1)
+			landing = (path >> (6 * i)) & 63;
+
+		out.captures.push_back(1ull << ((at + landing) / 2));
+		at = landing;
+	}
+
+	return out;
+}
+
+
+// compute all the jumps continuing the chain of the given piece, recursively
 //   out is the output moves
-//   captures is the stack of captures
-//   origin is the root call piece position
-//   at is the current, backtracking piece position to calculate future captures from
+//   partial is the move made so far, from the origin to the current piece position
+//   at is the current, backtracking piece square index to calculate future captures from
 //   player is the bitmask for the player's pieces
 //   other is the backtracking other player's pieces
-//   direction is the direction headed by the piece, updated during promotions
+//   direction is the direction headed by the piece, 0 for kings
 static void checkers_compute_jumps(
-	std::vector<checkers::move> &out,
-	const std::vector<uint64_t> &captures,
-	uint64_t origin,
-	uint64_t at,
+	checkers::move_list &out,
+	const checkers::compact_move &partial,
+	int at,
 	uint64_t player, uint64_t other,
 	int direction
 )
 {
-	constexpr int width = G_CHECKERS_WIDTH;
 	constexpr uint64_t boardmask = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
-	constexpr uint64_t toprow = make_checkers_bitboard(width - 1, width - 1);
+	constexpr uint64_t toprow = make_checkers_bitboard(G_CHECKERS_WIDTH - 1, G_CHECKERS_WIDTH - 1);
 	constexpr uint64_t bottomrow = make_checkers_bitboard(0, 0);
 
+	// stop the chain when the move cannot hold more captures
+	if (partial.length >= G_MAXCAPTURES)
+		return;
 
-	// check four diagonals
-	// and filter the diagonals facing the wrong direction
-	constexpr static int forward[2] = { (width - 1), (width + 1) };
-	constexpr static int backward[2] = { -(width + 1), -(width - 1) };
+	uint64_t empty = boardmask & ~(player | other);
+	uint64_t piece = 1ull << at;
 
-	int n = 0;
-	static int shifts[4];
-	if (direction <= 0)
+	// filter the diagonals facing the wrong direction
+	int start = direction > 0 ? 2 : 0;
+	int end = direction < 0 ? 2 : 4;
+	for (int i = start; i < end; ++i)
 	{
-		shifts[n++] = backward[0];
-		shifts[n++] = backward[1];
-	}
-	if (direction >= 0)
-	{
-		shifts[n++] = forward[0];
-		shifts[n++] = forward[1];
-	}
+		int shift = diagonal_shifts[i];
 
-	for (int i = 0; i < n; ++i)
-	{
-		int shift = shifts[i];
-
-		// create mask
-		uint64_t mask;
-		if (shift < 0)
-			mask = at >> (-shift);
-		else
-			mask = at << shift;
-
-
-		// cannot jump without an enemy piece
-		if ((other & mask) == 0)
-			continue;
-
-
-		// check the second layer
-		uint64_t secondmask;
-		if (shift < 0)
-			secondmask = at >> (2 * -shift);
-		else
-			secondmask = at << (2 * shift);
-
-		// make sure the second move is on the board
-		secondmask &= boardmask;
-
-		// if occupied, or off the board,  continue
-		if ((player | other) & secondmask || secondmask == 0)
+		// jump over an enemy piece onto an empty square, without leaving the board
+		uint64_t mask = shift_bitboard(piece & diagonal_jump_masks[i], shift) & other;
+		uint64_t secondmask = shift_bitboard(mask, shift) & empty;
+		if (secondmask == 0)
 			continue;
 
-
 		// else consider this jump
-		std::vector<uint64_t> newcaptures(captures);
-		newcaptures.push_back(mask);
+		checkers::compact_move move = partial;
+		move.add_jump(at + shift, at + 2 * shift);
+		out.push_back(move);
 
-		// change to king if reached the end
-		bool promoted = false;
+		// the chain ends if the piece reached the end and promoted
+		bool promoted = (direction == 1 && (secondmask & toprow)) || (direction == -1 && (secondmask & bottomrow));
 
-		if ((direction == 1 && (secondmask & toprow)) || (direction == -1 && (secondmask & bottomrow)))
+		// iterate, delete other piece, shouldn't have to worry about player pieces
+		if (!promoted)
 		{
-			direction = 0;
-			promoted = true;
+			checkers_compute_jumps(out, move, at + 2 * shift, player, other ^ mask, direction);
 		}
+	}
+}
 
+// append all the captures of the player, the first jumps of all pieces are computed at once by shifting the whole bitboards
+//   player and other are the bitmasks of the pieces of each side
+//   kings is the bitmask of the player's kings
+//   maindirection is the direction headed by the player's men
+//   promotion is the row the player's men promote on
+static void checkers_compute_captures(
+	checkers::move_list &out,
+	uint64_t player, uint64_t other,
+	uint64_t kings,
+	int maindirection,
+	uint64_t promotion
+)
+{
+	constexpr uint64_t boardmask = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
 
-		out.push_back({ origin, secondmask, newcaptures, direction == 0 });
+	uint64_t empty = boardmask & ~(player | other);
 
+	// the pieces moving along the backward and forward diagonals
+	uint64_t backward = maindirection < 0 ? player : kings;
+	uint64_t forward = maindirection > 0 ? player : kings;
 
-		// iterate, delete other piece, shouldn't have to worry about player pieces
-		if (!promoted)
+	// first jumps, then continue the chains piece by piece
+	for (int i = 0; i < 4; ++i)
+	{
+		int shift = diagonal_shifts[i];
+		uint64_t pieces = i < 2 ? backward : forward;
+
+		uint64_t captures = shift_bitboard(pieces & diagonal_jump_masks[i], shift) & other;
+		uint64_t landings = shift_bitboard(captures, shift) & empty;
+		while (landings)
 		{
-			checkers_compute_jumps(out, newcaptures, origin, secondmask, player, other ^ mask, direction);
+			int landing = std::countr_zero(landings);
+			uint64_t landingmask = landings & (~landings + 1);
+			landings &= landings - 1;
+
+			int from = landing - 2 * shift;
+			checkers::compact_move move(from, from);
+			move.add_jump(landing - shift, landing);
+			out.push_back(move);
+
+			// a man reaching the promotion row ends the chain
+			bool king = (kings & (1ull << from)) != 0;
+			if (!king && (landingmask & promotion))
+				continue;
+
+			checkers_compute_jumps(out, move, landing, player, other ^ (1ull << (landing - shift)), king ? 0 : maindirection);
 		}
 	}
 }
@@ -403,7 +494,9 @@ checkers::board::board()
 // copy constructor
 checkers::board::board(uint64_t red, uint64_t black, uint64_t kings)
 	: m_red(red), m_black(black), m_kings(kings)
-{}
+{
+	rehash();
+}
 
 // string constructor
 checkers::board::board(std::string text)
@@ -464,11 +557,14 @@ checkers::board::board(std::string text)
 			m_kings |= mask;
 		}
 	}
+
+	rehash();
 }
 
 // moves constructor from initial positions
 checkers::board::board(std::vector<move> &moves)
 {
+	reset();
 	state turn = state::RED;
 
 	// play the moves
@@ -477,6 +573,7 @@ checkers::board::board(std::vector<move> &moves)
 		board newboard = perform_move(move, turn);
 		// copy board
 		copy(newboard);
+		turn = state_flip(turn);
 	}
 }
 
@@ -490,6 +587,7 @@ void checkers::board::reset()
 	m_red = red;
 	m_black = black;
 	m_kings = 0ull;
+	rehash();
 }
 
 // copy the state of another board to self
@@ -498,6 +596,7 @@ void checkers::board::copy(const board &other)
 	m_red = other.m_red;
 	m_black = other.m_black;
 	m_kings = other.m_kings;
+	m_hash = other.m_hash;
 }
 
 // returns the string stylized representation of the board and its states
@@ -553,6 +652,22 @@ std::string checkers::board::repr() const
 // returns a list of available moves given the current player
 std::vector<checkers::move> checkers::board::compute_moves(state turn) const
 {
+	move_list list;
+	compute_moves(turn, list);
+
+	std::vector<move> moves;
+	moves.reserve(list.size);
+	for (auto &move : list)
+		moves.push_back(move.expand());
+
+	return moves;
+}
+
+// fills the move list with the available moves given the current player
+// the quiet moves and first jumps of all pieces are computed at once by shifting the whole bitboards
+void checkers::board::compute_moves(state turn, move_list &out) const
+{
+	constexpr uint64_t boardmask = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
 	constexpr uint64_t toprow = make_checkers_bitboard(G_CHECKERS_WIDTH - 1, G_CHECKERS_WIDTH - 1);
 	constexpr uint64_t bottomrow = make_checkers_bitboard(0, 0);
 
@@ -576,160 +691,183 @@ std::vector<checkers::move> checkers::board::compute_moves(state turn) const
 		promotion = toprow;
 	}
 
-	// preallocate moves
-	std::vector<move> moves;
-	moves.reserve(15);
+	out.clear();
 
-	// helpers
-	constexpr uint64_t boardmask = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
-	int width = G_CHECKERS_WIDTH;
+	uint64_t empty = boardmask & ~(player | other);
+	uint64_t kings = player & m_kings;
 
-	// for storing the available directions
-	uint64_t directions[4];
+	// the pieces moving along the backward and forward diagonals
+	uint64_t backward = maindirection < 0 ? player : kings;
+	uint64_t forward = maindirection > 0 ? player : kings;
 
-	// for each player piece
-	constexpr auto masks = global::boardmask();
-	for (int i = 0; i < masks.size; ++i)
+	// quiet moves
+	for (int i = 0; i < 4; ++i)
 	{
-		uint64_t mask = masks.masks[i];
+		int shift = diagonal_shifts[i];
+		uint64_t pieces = i < 2 ? backward : forward;
 
-		// return if not the player's piece
-		if (!(player & mask))
-			continue;
-
-		// is the piece also a king
-		bool king = (m_kings & mask) != 0;
-
-		// found the piece at mask
-		// find its moves
-		int direction = maindirection;
-		if (king)
-			direction = 0;
-
-
-		// compute the forward and backward bitboards
-		int n = 0;
-		if (direction >= 0)
+		uint64_t targets = shift_bitboard(pieces & diagonal_step_masks[i], shift) & empty;
+		while (targets)
 		{
-			directions[n++] = mask << (width - 1);
-			directions[n++] = mask << (width + 1);
-		}
+			int to = std::countr_zero(targets);
+			targets &= targets - 1;
 
-		if (direction <= 0)
-		{
-			directions[n++] = mask >> (width - 1);
-			directions[n++] = mask >> (width + 1);
+			out.push_back({ to - shift, to });
 		}
+	}
 
-		for (int i = 0; i < n; ++i)
-		{
-			uint64_t to = directions[i];
+	checkers_compute_captures(out, player, other, kings, maindirection, promotion);
+}
 
-			// can only be a legal position
-			if ((to & boardmask) == 0)
-				continue;
+// fills the move list with the captures available to the current player, the quiet moves are left out
+void checkers::board::compute_captures(state turn, move_list &out) const
+{
+	constexpr uint64_t toprow = make_checkers_bitboard(G_CHECKERS_WIDTH - 1, G_CHECKERS_WIDTH - 1);
+	constexpr uint64_t bottomrow = make_checkers_bitboard(0, 0);
 
-			// cannot move to itself
-			if (to & player)
-				continue;
+	out.clear();
+	if (turn == state::RED)
+		checkers_compute_captures(out, m_red, m_black, m_red & m_kings, -1, bottomrow);
+	else
+		checkers_compute_captures(out, m_black, m_red, m_black & m_kings, 1, toprow);
+}
 
-			// cannot move to other
-			if (to & other)
-				continue;
+// fills the move list with the quiet moves without promotion the given player could have made last to reach the board
+// the origins of all pieces are computed at once by shifting the whole bitboards back along each diagonal
+void checkers::board::compute_unmoves(state turn, move_list &out) const
+{
+	constexpr uint64_t boardmask = make_checkers_bitboard(0, G_CHECKERS_WIDTH - 1);
 
-			// became king if reached promotion or is already king
-			bool becameking = (to & promotion) != 0 || king;
-			moves.push_back({ mask, to, {}, becameking });
-		}
+	uint64_t player = get_player(turn);
+	uint64_t kings = player & m_kings;
+	uint64_t empty = boardmask & ~(m_red | m_black);
 
+	// the pieces that moved along the backward and forward diagonals, a man that promoted is a king now,
+	// so the kings are only moved back as kings
+	uint64_t backward = turn == state::RED ? player : kings;
+	uint64_t forward = turn == state::BLACK ? player : kings;
 
-		// compute jumps
-		checkers_compute_jumps(moves, {}, mask, mask, player, other, direction);
-	}
+	out.clear();
+	for (int i = 0; i < 4; ++i)
+	{
+		int shift = diagonal_shifts[i];
+		uint64_t pieces = i < 2 ? backward : forward;
 
+		// a piece that arrived along the diagonal came from one step back along the opposite diagonal
+		uint64_t origins = shift_bitboard(pieces & diagonal_step_masks[3 - i], -shift) & empty;
+		while (origins)
+		{
+			int from = std::countr_zero(origins);
+			origins &= origins - 1;
 
-	return moves;
+			out.push_back({ from, from + shift });
+		}
+	}
 }
 
 // performs the given move based on the current player, returns a new board where the move is performed
 checkers::board checkers::board::perform_move(const checkers::move &move, state turn) const
 {
-	constexpr uint64_t toprow = make_checkers_bitboard(G_CHECKERS_WIDTH - 1, G_CHECKERS_WIDTH - 1);
-	constexpr uint64_t bottomrow = make_checkers_bitboard(0, 0);
+	return perform_move(compact_move(move), turn);
+}
 
-	uint64_t player, other;
-	uint64_t promotion;
+// performs the given compact move based on the current player, returns a new board where the move is performed
+checkers::board checkers::board::perform_move(const compact_move &move, state turn) const
+{
+	uint64_t from = 1ull << move.from;
+	uint64_t to = 1ull << move.to;
 
 	// assert that the turn is valid
-	if ((move.from & m_red) && turn != state::RED)
+	if ((from & m_red) && turn != state::RED)
 	{
 		std::cout << "Fuck" << std::endl;
 	}
 
-	if ((move.from & m_black) && turn != state::BLACK)
+	if ((from & m_black) && turn != state::BLACK)
 	{
 		std::cout << "Fuck" << std::endl;
 	}
 
-	if (turn == state::RED)
-	{
-		player = m_red;
-		other = m_black;
-		promotion = bottomrow;
-	}
-	else
-	{
-		player = m_black;
-		other = m_red;
-		promotion = toprow;
-	}
-
-	if (move.from == move.to)
+	if (from == to)
 	{
 		std::cout << "Fuck" << std::endl;
 	}
 
-	// move player piece
-	player &= ~move.from;
-	player |= move.to;
+	board out = *this;
+	undo undo;
+	out.make(move, undo);
+	return out;
+}
 
-	// is king if moving as a king, or entering a promotion square
-	bool isking = (m_kings & move.from) != 0 || (move.to & promotion) != 0;
+// performs the given compact move in place, the side moving is the owner of the piece at move.from
+void checkers::board::make(const compact_move &move, undo &undo)
+{
+	constexpr uint64_t toprow = make_checkers_bitboard(G_CHECKERS_WIDTH - 1, G_CHECKERS_WIDTH - 1);
+	constexpr uint64_t bottomrow = make_checkers_bitboard(0, 0);
+	static constexpr auto keys = global::zobrist();
 
-	// remove king
-	uint64_t king = m_kings & (~move.from);
-	// add king if became king
-	if (isking)
-		king |= move.to;
+	undo = { m_red, m_black, m_kings, m_hash };
 
+	uint64_t from = 1ull << move.from;
+	uint64_t to = 1ull << move.to;
+	uint64_t travel = from | to;
+	bool wasking = (m_kings & from) != 0;
 
-	// handle capture chains
-	for (auto cap : move.captures)
+	// is king if moving as a king, or entering a promotion square
+	bool isking;
+	int kind, otherkind;
+	if (m_red & from)
 	{
-		// remove pieces captured
-		other &= ~cap;
-		// also remove king on the captures
-		king &= ~cap;
+		m_red ^= travel;
+		m_black &= ~move.captures;
+		isking = wasking || (to & bottomrow) != 0;
+		kind = G_ZOBRIST_REDMAN;
+		otherkind = G_ZOBRIST_BLACKMAN;
 	}
-
-	if (turn == state::RED)
+	else
 	{
-		return { player, other, king };
+		m_black ^= travel;
+		m_red &= ~move.captures;
+		isking = wasking || (to & toprow) != 0;
+		kind = G_ZOBRIST_BLACKMAN;
+		otherkind = G_ZOBRIST_REDMAN;
 	}
-	else
+
+	// update the key for the moved and captured pieces
+	m_hash ^= keys.pieces[kind + wasking][move.from] ^ keys.pieces[kind + isking][move.to];
+
+	uint64_t captures = move.captures;
+	while (captures)
 	{
-		return { other, player, king };
+		int square = std::countr_zero(captures);
+		captures &= captures - 1;
+
+		m_hash ^= keys.pieces[otherkind + ((m_kings >> square) & 1)][square];
 	}
+
+	// move the king, and remove the kings captured
+	m_kings &= ~(from | move.captures);
+	if (isking)
+		m_kings |= to;
 }
 
+// takes back a move performed by make
+void checkers::board::unmake(const undo &undo)
+{
+	m_red = undo.red;
+	m_black = undo.black;
+	m_kings = undo.kings;
+	m_hash = undo.hash;
+}
 
 checkers::state checkers::board::get_state(state turn) const
 {
 	// get moves
-	std::vector<checkers::move> moves = compute_moves(turn);
+	move_list moves;
+	compute_moves(turn, moves);
 
 	// no moves means the other player wins
-	if (moves.size() == 0)
+	if (moves.empty())
 	{
 		if (turn == state::RED)
 			return state::BLACK;
@@ -752,6 +890,32 @@ uint64_t checkers::board::get_kings(state player) const
 	return get_player(player) & m_kings;
 }
 
+uint64_t checkers::board::get_hash(state turn) const
+{
+	static constexpr auto keys = global::zobrist();
+
+	if (turn == state::BLACK)
+		return m_hash ^ keys.side;
+	return m_hash;
+}
+
+void checkers::board::rehash()
+{
+	static constexpr auto keys = global::zobrist();
+
+	m_hash = 0ull;
+	for (int i = 0; i < G_CHECKERS_SIZE; ++i)
+	{
+		uint64_t mask = 1ull << i;
+		int king = (m_kings & mask) != 0;
+
+		if (m_red & mask)
+			m_hash ^= keys.pieces[G_ZOBRIST_REDMAN + king][i];
+		else if (m_black & mask)
+			m_hash ^= keys.pieces[G_ZOBRIST_BLACKMAN + king][i];
+	}
+}
+
 // return the string representation of the state
 std::string checkers::state_repr(state s)
 {
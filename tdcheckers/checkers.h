@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <cstdint>
 
 
 /*
@@ -50,6 +51,12 @@
 // The character for the blank piece
 #define G_BLANKPIECE ('.')
 
+// The capacity of a move list
+#define G_MAXMOVES (128)
+
+// The maximum number of captures in a single compact move
+#define G_MAXCAPTURES (11)
+
 
 namespace checkers
 {
@@ -138,6 +145,108 @@ namespace checkers
 	};
 
 
+	// Represents a move using square indices, without any allocations
+	// this is the move used by the move generator and the search, convert to a move for I/O
+	struct compact_move
+	{
+		// the bitmask of the pieces captured
+		uint64_t captures;
+
+		// the intermediate landing squares (excluding the last one), 6 bits each, first landing in the lowest bits
+		uint64_t path;
+
+		// the square index of the start of the move
+		uint8_t from;
+
+		// the square index of the end of the move
+		uint8_t to;
+
+		// the number of captures made
+		uint8_t length;
+
+		// uninitialized constructor, so move lists are cheap to create
+		compact_move() = default;
+
+		// quiet move constructor
+		compact_move(int from, int to)
+			: captures(0ull), path(0ull), from(from), to(to), length(0)
+		{}
+
+		// conversion constructor from a move
+		compact_move(const move &move);
+
+		// converts to a move
+		move expand() const;
+
+		// appends a jump over the square index over, landing at the square index landing
+		void add_jump(int over, int landing)
+		{
+			if (length > 0)
+				path |= (uint64_t)to << (6 * (length - 1));
+
+			captures |= 1ull << over;
+			to = landing;
+			length += 1;
+		}
+
+		// equality overload
+		bool operator==(const compact_move &other) const
+		{
+			return from == other.from && to == other.to && captures == other.captures && path == other.path;
+		}
+	};
+
+
+	// A fixed capacity list of moves, allocated on the stack
+	struct move_list
+	{
+		compact_move moves[G_MAXMOVES];
+		int size = 0;
+
+		// appends a move, ignored when the list is full
+		void push_back(const compact_move &move)
+		{
+			if (size < G_MAXMOVES)
+				moves[size++] = move;
+		}
+
+		void clear()
+		{
+			size = 0;
+		}
+
+		bool empty() const
+		{
+			return size == 0;
+		}
+
+		compact_move &operator[](int i)
+		{
+			return moves[i];
+		}
+
+		const compact_move &operator[](int i) const
+		{
+			return moves[i];
+		}
+
+		compact_move *begin() { return moves; }
+		compact_move *end() { return moves + size; }
+		const compact_move *begin() const { return moves; }
+		const compact_move *end() const { return moves + size; }
+	};
+
+
+
+	// The state needed to take back a move made on a board
+	struct undo
+	{
+		uint64_t red;
+		uint64_t black;
+		uint64_t kings;
+		uint64_t hash;
+	};
+
 
 	// Represents the checkers board and its pieces
 	class board
@@ -167,9 +276,29 @@ namespace checkers
 		// returns a list of available moves given the current player
 		std::vector<move> compute_moves(state turn) const;
 
+		// fills the move list with the available moves given the current player
+		void compute_moves(state turn, move_list &out) const;
+
+		// fills the move list with only the captures given the current player, in the order compute_moves lists them
+		void compute_captures(state turn, move_list &out) const;
+
+		// fills the move list with the quiet moves without promotion the given player could have made last to reach the board,
+		// the board before such a move is the board after performing the move from its to back to its from
+		void compute_unmoves(state turn, move_list &out) const;
+
 		// performs the given move based on the current player, returns a new board where the move is performed
 		board perform_move(const checkers::move &move, state turn) const;
 
+		// performs the given compact move based on the current player, returns a new board where the move is performed
+		board perform_move(const compact_move &move, state turn) const;
+
+		// performs the given compact move in place, the side moving is the owner of the piece at move.from
+		// the information to take the move back is written to undo
+		void make(const compact_move &move, undo &undo);
+
+		// takes back a move performed by make
+		void unmake(const undo &undo);
+
 		// returns the board state given the current player turn
 		// note: this does not handle drawing yet
 		state get_state(state turn) const;
@@ -186,16 +315,20 @@ namespace checkers
 			// a functor representing the hash function of our board
 			size_t operator()(const board &board) const
 			{
-				size_t h1 = board.m_red | (board.m_black >> 1);
-				size_t h3 = std::hash<uint64_t>()(board.m_kings);
-
-				return h1 ^ (h3 << 1);
+				return board.m_hash;
 			}
 		};
 
 		uint64_t get_player(state player) const;
 		uint64_t get_kings(state player) const;
 
+		// returns the zobrist key of the board with the given player to move
+		uint64_t get_hash(state turn) const;
+
+	private:
+		// recomputes the zobrist key of the pieces from scratch
+		void rehash();
+
 	private:
 		// the red player's bit mask
 		uint64_t m_red;
@@ -205,6 +338,9 @@ namespace checkers
 
 		// the king's (of both player) bit mask
 		uint64_t m_kings;
+
+		// the zobrist key of the pieces, updated incrementally by make
+		uint64_t m_hash;
 	};
 }
 
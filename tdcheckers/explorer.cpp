@@ -5,29 +5,282 @@
 #include <random>
 #include <thread>
 #include <mutex>
+#include <deque>
+#include <cmath>
+#include <bit>
+#include <chrono>
 
 #include "global.h"
 
-explorer::optimizer::optimizer(checkers::board board, checkers::state turn)
-	: m_board(board), m_player(turn), m_score(0), m_best(), m_lines()
+// the minimum depth remaining for a node to split its siblings across threads in the ybwc search
+#define G_YBWC_MINDEPTH (3)
+
+// the first depth searched with an aspiration window, and the initial half width of the window
+#define G_ASPIRATION_MINDEPTH (5)
+#define G_ASPIRATION_WINDOW (0.5f)
+
+// zero window passes of mtd(f) before the remaining bounds are searched with an open window
+#define G_MTDF_PASSES (8)
+
+// late move reductions, the minimum depth remaining and move index reduced, and the ones reduced by another ply
+#define G_LMR_MINDEPTH (3)
+#define G_LMR_MINMOVE (3)
+#define G_LMR_DEEPDEPTH (6)
+#define G_LMR_DEEPMOVE (6)
+
+// futility pruning and razoring, the maximum depth remaining and the margin per ply over the static eval
+#define G_FUTILITY_DEPTH (2)
+#define G_FUTILITY_MARGIN (1.0f)
+#define G_RAZOR_DEPTH (2)
+#define G_RAZOR_MARGIN (1.5f)
+
+// internal iterative deepening, the minimum depth remaining of pv and expected cut nodes searched without a hash move,
+// and the plies the search for the move is reduced by at pv nodes, the cut nodes search half the depth
+#define G_IID_PVDEPTH (4)
+#define G_IID_CUTDEPTH (7)
+#define G_IID_REDUCTION (2)
+
+// the nodes a search thread explores between checks of the search limits
+#define G_POLL_NODES (1024)
+
+// the time kept in reserve on the game clock, and the moves assumed left in the game, in milliseconds
+#define G_TIME_RESERVE (50)
+#define G_TIME_MOVES (30)
+
+// the number of pieces on the board at or below which the threat extension applies
+#define G_EXTENSION_ENDGAME (8)
+
+explorer::optimizer::optimizer(checkers::board board, checkers::state turn, int threads)
+	: optimizer(board, turn, std::make_shared<transpositiontable>(), threads)
 {
 }
 
-// ds to store some evaluation globals
-struct evaluate_extra
+explorer::optimizer::optimizer(checkers::board board, checkers::state turn, std::shared_ptr<transpositiontable> table, int threads)
+	: m_board(board), m_player(turn), m_score(0), m_best(), m_lines(), m_transposition(std::move(table)),
+	m_pool(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())), m_mode(search_mode::LAZY_SMP),
+	m_root(root_search::ALPHABETA), m_limits(), m_options(),
+	m_nodes(0), m_qnodes(0), m_depth(0), m_stats(), m_search(), m_finished(true), m_progress(), m_finished_callback(), m_orderings()
+{
+	set_threads(m_pool.size());
+}
+
+explorer::optimizer::~optimizer()
+{
+	stop();
+}
+
+struct split_point;
+
+// a line of moves, the rows of the triangular principal variation table
+struct pv_line
+{
+	int length;
+	checkers::compact_move moves[G_MAXPLY];
+};
+
+// a sibling waiting to be searched by any thread
+struct split_task
+{
+	split_point *point;
+	checkers::compact_move move;
+};
+
+// a deque of tasks per thread, the owner pushes and pops at the back, thieves steal from the front
+struct work_queue
 {
-	// lock for the transposition table
 	std::mutex lock;
+	std::deque<split_task> tasks;
+};
 
+// ds to store the evaluation globals shared by all search threads
+// the state is kept by the optimizer from the start of a search until the next one
+struct search_shared
+{
 	// the transposition table
-	explorer::transpositiontable transposition;
+	explorer::transpositiontable &transposition;
+
+	// set to abort the searches of all threads
+	std::atomic<bool> stop;
+
+	// the position searched and its side to move
+	checkers::board board;
+	checkers::state turn;
+	bool verbose;
+
+	// the limits of the search, they are engaged at the start, or at the ponderhit of a ponder search
+	explorer::search_limits limits;
+	std::atomic<bool> pondering;
+
+	// when the limits were engaged, restarted by a ponderhit while the threads search, in steady clock ticks
+	std::atomic<int64_t> start;
+
+	// the nodes of all threads, and the node count, hard deadline and soft deadline to stop at, 0 if none
+	// the soft deadline is when the main thread starts no new iteration, the deadlines are in steady clock ticks
+	std::atomic<size_t> nodes;
+	std::atomic<size_t> nodelimit;
+	std::atomic<int64_t> deadline;
+	std::atomic<int64_t> softline;
+
+	// the parallel search strategy
+	explorer::search_mode mode;
 
-	// number of board positions explored
+	// the selective search techniques used
+	explorer::search_options options;
+
+	// the number of search threads, and their work queues (ybwc)
+	int threads;
+	std::unique_ptr<work_queue[]> queues;
+};
+
+// ds to store some evaluation globals of a search thread
+struct evaluate_extra
+{
+	search_shared &shared;
+
+	// number of board positions explored, and how many of them were quiescence nodes
 	size_t exploration;
+	size_t quiescence;
+
+	// the nodes explored since the shared count was last updated
+	size_t unreported;
+
+	std::optional<checkers::compact_move> best;
+
+	// the index of the search thread
+	int thread;
+
+	// the split point of the task being searched (ybwc), nullptr if none
+	split_point *split;
+
+	// the move ordering tables of the thread
+	explorer::move_ordering &ordering;
+
+	// the counters of the selective search techniques
+	explorer::search_stats stats;
+
+	// the moves made at each ply of the current line
+	checkers::compact_move path[G_MAXPLY];
+
+	// the extension units collected by the current line up to each ply
+	int extended[G_MAXPLY + 1];
+
+	// the triangular principal variation table, row ply holds the best line found from the node at ply
+	std::unique_ptr<pv_line[]> pv;
 
-	std::optional<checkers::move> best;
+	// the best root move of the current iteration so far, with its value and line, kept if the iteration is stopped
+	std::optional<checkers::compact_move> partial;
+	float partialvalue;
+	pv_line partialline;
 };
 
+// a node whose siblings are searched in parallel, after its eldest brother was searched
+struct split_point
+{
+	// the split point of the enclosing task, its cutoffs cancel this split point too
+	split_point *parent;
+
+	// the position and window of the node
+	checkers::board board;
+	checkers::state turn;
+	int depth;
+	int ply;
+	float beta;
+
+	// the move leading to the node, for the countermoves
+	const checkers::compact_move *previous;
+
+	// the extension units collected up to the node, and whether the threat extension applies
+	int extended;
+	bool endgame;
+
+	// the improved alpha, best value and move so far, guarded by lock
+	std::mutex lock;
+	float alpha;
+	float value;
+	std::optional<checkers::compact_move> best;
+
+	// the principal variation of the node, guarded by lock
+	pv_line line;
+
+	// set when a sibling failed high, the siblings not yet finished are cancelled
+	std::atomic<bool> cutoff;
+
+	// the number of siblings not yet finished
+	std::atomic<int> pending;
+};
+
+// whether the search of the thread has been stopped, or cancelled by a cutoff at an enclosing split point
+static bool aborted(const evaluate_extra &extra)
+{
+	if (extra.shared.stop.load(std::memory_order_relaxed))
+		return true;
+
+	for (split_point *point = extra.split; point != nullptr; point = point->parent)
+	{
+		if (point->cutoff.load(std::memory_order_relaxed))
+			return true;
+	}
+
+	return false;
+}
+
+// counts a node explored by the thread, and every so often adds the nodes to the shared count
+// and stops the search when it runs out of nodes or time
+static void count_node(evaluate_extra &extra)
+{
+	extra.exploration += 1;
+	extra.unreported += 1;
+	if (extra.unreported < G_POLL_NODES)
+		return;
+
+	search_shared &shared = extra.shared;
+	size_t nodes = shared.nodes += extra.unreported;
+	extra.unreported = 0;
+
+	size_t nodelimit = shared.nodelimit.load(std::memory_order_relaxed);
+	if (nodelimit > 0 && nodes >= nodelimit)
+		shared.stop = true;
+
+	int64_t deadline = shared.deadline.load(std::memory_order_relaxed);
+	if (deadline > 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline)
+		shared.stop = true;
+}
+
+// returns the deepest iteration of the limits, 0 and below search to the deepest ply
+static int limit_depth(int depth)
+{
+	return depth > 0 ? std::min(depth, G_MAXPLY - 1) : G_MAXPLY - 1;
+}
+
+// returns the time in milliseconds allocated to the move by the limits, 0 if unlimited
+// a fixed move time is used as is, otherwise the time left is spread over the moves until the time control
+static int64_t allocate_time(const explorer::search_limits &limits)
+{
+	if (limits.movetime > 0)
+		return limits.movetime;
+
+	if (limits.time <= 0)
+		return 0;
+
+	int moves = limits.movestogo > 0 ? limits.movestogo : G_TIME_MOVES;
+	int64_t available = std::max<int64_t>(limits.time - G_TIME_RESERVE, 1);
+	int64_t allocation = available / moves + limits.increment * 3 / 4;
+	return std::clamp<int64_t>(allocation, 1, available);
+}
+
+// starts the clock and the node budget of the limits from now
+static void engage_limits(search_shared &shared)
+{
+	auto now = std::chrono::steady_clock::now();
+	int64_t allocation = allocate_time(shared.limits);
+
+	shared.start = now.time_since_epoch().count();
+	shared.nodelimit = shared.limits.nodes > 0 ? shared.nodes + shared.limits.nodes : 0;
+	shared.deadline = allocation > 0 ? (now + std::chrono::milliseconds(allocation)).time_since_epoch().count() : 0;
+	shared.softline = allocation > 0 ? (now + std::chrono::milliseconds(allocation / 2)).time_since_epoch().count() : 0;
+	shared.pondering = false;
+}
+
 
 // helper function to get the sign of the function
 template <typename T>
@@ -168,344 +421,747 @@ static float heuristic(
 	return selfscore - otherscore;
 }
 
-// Returns the weighting of the moves
-static std::vector<float> weight_moves(
-	checkers::board board,
-	const std::vector<checkers::move> &moves,
+// Returns the transposition key of the board with the turn to move
+static uint64_t position_hash(const checkers::board &board, checkers::state turn)
+{
+	return board.get_hash(turn);
+}
+
+template <bool TOP>
+static float evaluate(
+	checkers::board &board,
+	checkers::state turn,
+	int depth_remaining,
+	int ply,
+	float alpha, float beta,
+	evaluate_extra &extra
+);
+
+// sets the line to the move followed by the line of the child
+static void update_pv(pv_line &line, const checkers::compact_move &move, const pv_line &child)
+{
+	line.moves[0] = move;
+	std::copy(child.moves, child.moves + child.length, line.moves + 1);
+	line.length = child.length + 1;
+}
+
+// fail-soft capture search at the horizon, so positions in the middle of an exchange are not evaluated statically
+// captures are optional, so the side moving may stand pat on the heuristic instead of capturing
+static float quiesce(
+	checkers::board &board,
 	checkers::state turn,
-	checkers::state player,
-	evaluate_extra &extra,
-	bool maxing
+	int ply,
+	float alpha, float beta,
+	evaluate_extra &extra
 )
 {
-	std::vector<float> out;
-	out.reserve(moves.size());
+	count_node(extra);
+	extra.quiescence += 1;
+	extra.pv[ply].length = 0;
+
+	if (aborted(extra))
+		return 0.0f;
+
+	// the side without pieces loses, a side blocked with pieces left is only found by the full search
+	if (board.get_player(turn) == 0)
+		return -1e6;
 
-	checkers::state other = checkers::state_flip(turn);
+	float value = heuristic(board, turn, turn);
+	if (value >= beta || ply >= G_MAXPLY - 1)
+		return value;
 
-	extra.lock.lock();
-	for (auto &move : moves)
+	checkers::move_list captures;
+	board.compute_captures(turn, captures);
+
+	int indices[G_MAXMOVES];
+	extra.ordering.order(captures, indices, turn, ply, nullptr, nullptr);
+
+	float a = std::max(alpha, value);
+	checkers::undo undo;
+	for (int k = 0; k < captures.size; ++k)
 	{
-		checkers::board newboard = board.perform_move(move, turn);
+		auto &move = captures[indices[k]];
+
+		extra.path[ply] = move;
+		board.make(move, undo);
+		float newvalue = -quiesce(board, checkers::state_flip(turn), ply + 1, -beta, -a, extra);
+		board.unmake(undo);
+
+		value = std::max(value, newvalue);
+
+		if (newvalue > a && newvalue < beta)
+			update_pv(extra.pv[ply], move, extra.pv[ply + 1]);
+
+		a = std::max(a, newvalue);
+		if (beta <= a)
+			break;
+	}
 
-		float caps = move.captures.size();
-		if (!maxing)
-			caps *= -1.0f;
+	return value;
+}
 
-		// top move bonus
-		uint64_t hash = checkers::board::hash_function()(newboard) ^ std::hash<bool>()(other == player);
-		if (extra.transposition.count(hash) == 0)
+// searches the child of the move, returns its value from the perspective of the turn moving
+static float search_move(
+	checkers::board &board,
+	checkers::state turn,
+	const checkers::compact_move &move,
+	int depth_remaining,
+	int ply,
+	float alpha, float beta,
+	evaluate_extra &extra
+)
+{
+	checkers::undo undo;
+
+	extra.path[ply] = move;
+	board.make(move, undo);
+	float value = -evaluate<false>(
+		board,
+		checkers::state_flip(turn),
+		depth_remaining - 1,
+		ply + 1,
+		-beta,
+		-alpha,
+		extra
+	);
+	board.unmake(undo);
+
+	return value;
+}
+
+// searches a sibling after the first with principal variation search, it is expected to fail low,
+// so a null window scout is searched first, and only when it fails high is the full window searched
+static float search_scout(
+	checkers::board &board,
+	checkers::state turn,
+	const checkers::compact_move &move,
+	int depth_remaining,
+	int ply,
+	float alpha, float beta,
+	evaluate_extra &extra
+)
+{
+	float value = search_move(board, turn, move, depth_remaining, ply, alpha, std::nextafter(alpha, beta), extra);
+	if (value > alpha && value < beta)
+		value = search_move(board, turn, move, depth_remaining, ply, alpha, beta, extra);
+
+	return value;
+}
+
+// returns the extension units the options give the move
+// count is the number of moves of the position, and endgame whether few enough pieces are left for threats
+static int extension_units(
+	const checkers::board &board,
+	checkers::state turn,
+	const checkers::compact_move &move,
+	int count,
+	bool endgame,
+	evaluate_extra &extra
+)
+{
+	const int *extensions = extra.shared.options.extensions;
+	int units = 0;
+
+	auto fire = [&](explorer::extension kind)
+	{
+		units += extensions[(int)kind];
+		extra.stats.extensions[(int)kind] += 1;
+	};
+
+	if (extensions[(int)explorer::extension::CAPTURES] > 0 && move.length >= 2)
+		fire(explorer::extension::CAPTURES);
+
+	// a man promotes on the far row of its direction
+	if (extensions[(int)explorer::extension::PROMOTION] > 0 && (board.get_kings(turn) & (1ull << move.from)) == 0)
+	{
+		int promotionrow = turn == checkers::state::RED ? 0 : G_CHECKERS_WIDTH - 1;
+		if (move.to / G_CHECKERS_WIDTH == promotionrow)
+			fire(explorer::extension::PROMOTION);
+	}
+
+	if (extensions[(int)explorer::extension::SINGLE_REPLY] > 0 && count == 1)
+		fire(explorer::extension::SINGLE_REPLY);
+
+	if (extensions[(int)explorer::extension::THREAT] > 0 && endgame)
+	{
+		checkers::move_list captures;
+		board.perform_move(move, turn).compute_captures(turn, captures);
+		if (!captures.empty())
+			fire(explorer::extension::THREAT);
+	}
+
+	return units;
+}
+
+// returns the whole plies the move is extended by, the fractions carry over along the line
+// extended is the extension units collected up to the node at ply, the child's are written to the path
+static int extend(
+	const checkers::board &board,
+	checkers::state turn,
+	const checkers::compact_move &move,
+	int count,
+	bool endgame,
+	int ply,
+	int extended,
+	evaluate_extra &extra
+)
+{
+	int units = extension_units(board, turn, move, count, endgame, extra);
+	int total = std::min(extended + units, extra.shared.options.extension_budget);
+	extra.extended[ply + 1] = std::max(total, extended);
+
+	int plies = std::max(0, total / G_EXTENSION_PLY - extended / G_EXTENSION_PLY);
+	extra.stats.extended += plies;
+	return plies;
+}
+
+// returns whether the split point is the ancestor split point or nested below it
+static bool split_descends(const split_point *point, const split_point *ancestor)
+{
+	for (; point != nullptr; point = point->parent)
+	{
+		if (point == ancestor)
+			return true;
+	}
+
+	return false;
+}
+
+// pops the most recently pushed task of the split point from the thread's own queue
+static bool pop_task(evaluate_extra &extra, split_point *point, split_task &out)
+{
+	work_queue &queue = extra.shared.queues[extra.thread];
+	std::lock_guard<std::mutex> guard(queue.lock);
+
+	if (queue.tasks.empty() || queue.tasks.back().point != point)
+		return false;
+
+	out = queue.tasks.back();
+	queue.tasks.pop_back();
+	return true;
+}
+
+// steals the oldest task from another thread's queue, restricted to the split points below ancestor if given
+static bool steal_task(evaluate_extra &extra, split_point *ancestor, split_task &out)
+{
+	for (int i = 1; i < extra.shared.threads; ++i)
+	{
+		work_queue &queue = extra.shared.queues[(extra.thread + i) % extra.shared.threads];
+		std::lock_guard<std::mutex> guard(queue.lock);
+
+		for (auto it = queue.tasks.begin(); it != queue.tasks.end(); ++it)
+		{
+			if (ancestor != nullptr && !split_descends(it->point, ancestor))
+				continue;
+
+			out = *it;
+			queue.tasks.erase(it);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// searches the sibling of the task, and merges its value into the split point
+static void run_task(const split_task &task, evaluate_extra &extra)
+{
+	split_point &point = *task.point;
+	split_point *enclosing = extra.split;
+	extra.split = &point;
+
+	if (!aborted(extra))
+	{
+		float alpha;
 		{
-			float heur = heuristic(newboard, other, player);
-			out.push_back(0.8f * heur + caps);
+			std::lock_guard<std::mutex> guard(point.lock);
+			alpha = point.alpha;
 		}
-		else
+
+		// a split node has more than one move, so none of the siblings is a single reply
+		checkers::board board = point.board;
+		int plies = extend(board, point.turn, task.move, 2, point.endgame, point.ply, point.extended, extra);
+		float newvalue = search_scout(board, point.turn, task.move, point.depth + plies, point.ply, alpha, point.beta, extra);
+
+		if (!aborted(extra))
+		{
+			std::lock_guard<std::mutex> guard(point.lock);
+			if (newvalue > point.value)
+			{
+				point.value = newvalue;
+				point.best = task.move;
+			}
+
+			if (newvalue > point.alpha && newvalue < point.beta)
+				update_pv(point.line, task.move, extra.pv[point.ply + 1]);
+
+			point.alpha = std::max(point.alpha, newvalue);
+			if (point.alpha >= point.beta && !point.cutoff)
+			{
+				point.cutoff = true;
+				extra.ordering.cutoff(task.move, point.turn, point.ply, point.depth, point.previous);
+			}
+		}
+	}
+
+	extra.split = enclosing;
+
+	// the owner may release the split point once this reaches 0, so it is the last access
+	point.pending -= 1;
+}
+
+// splits the remaining siblings of a node across the threads, and searches them until all finished
+// alpha, value and best are updated with the results of the siblings
+static void split(
+	checkers::board &board,
+	checkers::state turn,
+	int depth_remaining,
+	int ply,
+	const checkers::compact_move *siblings,
+	int count,
+	bool endgame,
+	float beta,
+	float &alpha,
+	float &value,
+	std::optional<checkers::compact_move> &best,
+	evaluate_extra &extra
+)
+{
+	split_point point;
+	point.parent = extra.split;
+	point.board = board;
+	point.turn = turn;
+	point.depth = depth_remaining;
+	point.ply = ply;
+	point.previous = ply > 0 ? &extra.path[ply - 1] : nullptr;
+	point.extended = extra.extended[ply];
+	point.endgame = endgame;
+	point.beta = beta;
+	point.alpha = alpha;
+	point.value = value;
+	point.best = best;
+	point.line = extra.pv[ply];
+	point.cutoff = false;
+	point.pending = count;
+
+	// push the best sibling last, so the owner pops it first while thieves take the worst ones
+	{
+		work_queue &queue = extra.shared.queues[extra.thread];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		for (int i = count - 1; i >= 0; --i)
 		{
-			out.push_back(extra.transposition[hash].value + caps);
+			queue.tasks.push_back({ &point, siblings[i] });
 		}
 	}
-	extra.lock.unlock();
 
-	return out;
+	// search our own siblings, then help the threads searching the rest
+	split_task task;
+	while (point.pending.load() > 0)
+	{
+		if (pop_task(extra, &point, task) || steal_task(extra, &point, task))
+			run_task(task, extra);
+		else
+			std::this_thread::yield();
+	}
+
+	alpha = point.alpha;
+	value = point.value;
+	best = point.best;
+	extra.pv[ply] = point.line;
 }
 
-// alpha-beta evaluation function (or at least, it should be)
+// the loop of the ybwc helper threads, stealing siblings until the search is stopped
+static void ybwc_helper(evaluate_extra &extra)
+{
+	split_task task;
+	while (!extra.shared.stop.load(std::memory_order_relaxed))
+	{
+		if (steal_task(extra, nullptr, task))
+			run_task(task, extra);
+		else
+			std::this_thread::yield();
+	}
+}
+
+// fail-soft negamax alpha-beta evaluation function, the score is from the perspective of the turn moving
+// values outside the window are bounds on the score, which the zero window searches of mtd(f) rely on
 // whether this is the top level call
 template <bool TOP>
 static float evaluate(
-	// the current board state
-	checkers::board board,
+	// the current board state, moves are made and taken back in place
+	checkers::board &board,
 	// the turn
 	checkers::state turn,
-	// the player to compute score against
-	checkers::state player,
 	// depth search remaining
 	int depth_remaining,
+	// the distance from the root
+	int ply,
 	// alpha beta values
 	float alpha, float beta,
-	// whether to min or max
-	bool maxing,
 	// extra info
-	evaluate_extra &extra,
-	// precalculated moves
-	std::vector<checkers::move> &&precalc
+	evaluate_extra &extra
 )
 {
-	extra.exploration += 1;
+	count_node(extra);
+	extra.pv[ply].length = 0;
+
+	// the result of an aborted search is discarded
+	if (aborted(extra))
+		return 0.0f;
 
 	// use transposition
-	uint64_t hash = checkers::board::hash_function()(board) ^ std::hash<bool>()(turn == player);
+	uint64_t hash = position_hash(board, turn);
 
-	// transposition lookup
-	if (!TOP)
+	// transposition lookup, the root is always searched so it has a best move
+	explorer::ttable data;
+	bool found = extra.shared.transposition.probe(hash, data);
+	if (!TOP && found)
 	{
-		extra.lock.lock();
-		if (extra.transposition.count(hash) != 0)
+		// only return the transposition if the stored depth is higher than remaining
+		if (data.depth >= depth_remaining)
 		{
-			auto &data = extra.transposition[hash];
-
-			// only return the transposition if the stored depth is higher than remaining
-			if (data.depth >= depth_remaining)
-			{
-				if (data.alpha >= beta)
-				{
-					extra.lock.unlock();
-					return data.alpha;
-				}
+			if (data.type == explorer::bound::EXACT)
+				return data.value;
 
-				if (data.beta <= alpha)
-				{
-					extra.lock.unlock();
-					return data.beta;
-				}
+			if (data.type == explorer::bound::LOWER && data.value >= beta)
+				return data.value;
 
-				alpha = std::max(alpha, data.alpha);
-				beta = std::min(beta, data.beta);
-			}
+			if (data.type == explorer::bound::UPPER && data.value <= alpha)
+				return data.value;
 		}
-		extra.lock.unlock();
 	}
 
 
+	checkers::move_list moves;
+	board.compute_moves(turn, moves);
 
-	std::vector<checkers::move> moves = std::move(precalc);
-	if (moves.size() == 0)
+	// the side without moves loses
+	if (moves.empty())
 	{
-		if (turn == player)
-		{
-			/*extra.lock.lock();
-			extra.transposition[hash] = { 1000, -1e6, 100 };
-			extra.lock.unlock();*/
-			return -1e6;
-		}
-		else
-		{
-			/*extra.lock.lock();
-			extra.transposition[hash] = { 1000, 1e6, 100 };
-			extra.lock.unlock();*/
-			return 1e6;
-		}
+		return -1e6;
 	}
 
 
-	if (depth_remaining == 0)
+	if (ply >= G_MAXPLY - 1)
 	{
-		float score = heuristic(board, turn, player);
-		/*extra.lock.lock();
-		extra.transposition[hash] = { 0, score, 2 };
-		extra.lock.unlock();*/
+		return heuristic(board, turn, turn);
+	}
 
-		return score;
+	// resolve the captures at the horizon
+	if (depth_remaining == 0)
+	{
+		return quiesce(board, turn, ply, alpha, beta, extra);
 	}
 
 
-	checkers::state nextturn = checkers::state_flip(turn);
+	// a null window node is expected to fail, so it may be searched selectively
+	const explorer::search_options &options = extra.shared.options;
+	bool pvnode = std::nextafter(alpha, beta) < beta;
+	bool selective = !TOP && !pvnode && std::abs(alpha) < 100.0f;
+
+	// the static eval decides the pruning near the leaves
+	float staticvalue = 0.0f;
+	if (selective && depth_remaining <= std::max(G_FUTILITY_DEPTH, G_RAZOR_DEPTH))
+		staticvalue = heuristic(board, turn, turn);
 
-	// move ordering
-	std::vector<int> indices(moves.size());
-	std::iota(indices.begin(), indices.end(), 0);
-	if (!TOP)
+	// razoring, a node far below alpha is only searched for captures, unless they bring it back above alpha
+	if (options.razoring && selective && depth_remaining <= G_RAZOR_DEPTH
+		&& staticvalue + G_RAZOR_MARGIN * depth_remaining <= alpha)
 	{
-		// sort moves based on weights, desc
-		auto weights = weight_moves(board, moves, turn, player, extra, maxing);
-		std::sort(indices.begin(), indices.end(), [&](int a, int b)
+		float razorvalue = quiesce(board, turn, ply, alpha, beta, extra);
+		if (razorvalue <= alpha)
 		{
-			if (maxing)
-			{
-				return weights[a] > weights[b];
-			}
-			return weights[a] < weights[b];
-		});
+			extra.stats.razoring += 1;
+			return razorvalue;
+		}
 	}
 
-	float value;
-	if (maxing)
+	// probcut, a shallow search of the node predicts the deep one, cut when the prediction clears the window by the threshold
+	const explorer::probcut_model &model = options.probcut_params;
+	if (options.probcut && selective && depth_remaining >= model.deep)
 	{
-		value = alpha;
-		float a = alpha;
+		int shallow = depth_remaining - (model.deep - model.shallow);
 
-		if (TOP)
+		// the shallow score at which the deep one is expected above beta
+		float high = (beta + model.highthreshold * model.sigma - model.intercept) / model.slope;
+		if (std::abs(high) < 100.0f)
 		{
-			std::vector<float> evals;
-			auto eval = [&](int i)
+			float shallowvalue = evaluate<false>(board, turn, shallow, ply, std::nextafter(high, -1e9f), high, extra);
+			if (shallowvalue >= high)
 			{
-				auto &move = moves[i];
-
-				float newvalue = evaluate<false>(
-					board.perform_move(move, turn),
-					nextturn,
-					player,
-					depth_remaining - 1,
-					alpha,
-					beta,
-					false,
-					extra,
-					board.perform_move(move, turn).compute_moves(nextturn)
-				);
-
-				evals[i] = newvalue;
-			};
-
-			std::vector<std::thread> threads;
-			for (int i = 0; i < moves.size(); ++i)
-			{
-				evals.push_back(0.0f);
-				threads.push_back(std::thread{ eval, i });
+				extra.stats.probcut += 1;
+				return beta;
 			}
+		}
 
-
-			for (int i = 0; i < moves.size(); ++i)
+		// the shallow score at which the deep one is expected below alpha
+		float low = (alpha - model.lowthreshold * model.sigma - model.intercept) / model.slope;
+		if (std::abs(low) < 100.0f)
+		{
+			float shallowvalue = evaluate<false>(board, turn, shallow, ply, low, std::nextafter(low, 1e9f), extra);
+			if (shallowvalue <= low)
 			{
-				threads[i].join();
+				extra.stats.probcut += 1;
+				return alpha;
 			}
+		}
+	}
+
+	// futility pruning, the quiet moves of a node far below alpha cannot raise it
+	float futilityvalue = staticvalue + G_FUTILITY_MARGIN * depth_remaining;
+	bool futile = options.futility && selective && depth_remaining <= G_FUTILITY_DEPTH && futilityvalue <= alpha;
+
+	// the index of the best move stored in the transposition
+	int hashindex = found && data.move < moves.size ? data.move : -1;
+
+	// internal iterative deepening, a node likely to be searched fully without a hash move
+	// recovers one from a shallower search of itself, which stores its best move in the transposition
+	if (options.iid && !TOP && hashindex < 0)
+	{
+		int iiddepth = 0;
+		if (pvnode && depth_remaining >= G_IID_PVDEPTH)
+			iiddepth = depth_remaining - G_IID_REDUCTION;
+		else if (!pvnode && depth_remaining >= G_IID_CUTDEPTH)
+			iiddepth = depth_remaining / 2;
+
+		if (iiddepth > 0)
+		{
+			extra.stats.iid += 1;
+			evaluate<false>(board, turn, iiddepth, ply, alpha, beta, extra);
 
-			for (int i = 0; i < moves.size(); ++i)
+			explorer::ttable iiddata;
+			if (extra.shared.transposition.probe(hash, iiddata) && iiddata.move >= 0 && iiddata.move < moves.size)
 			{
-				if (evals[i] > value)
-				{
-					value = evals[i];
-					extra.best = moves[i];
-				}
+				extra.stats.iidmoves += 1;
+				hashindex = iiddata.move;
 			}
 		}
-		else
+	}
+
+	// move ordering, the root searches the best move of the previous iteration first,
+	// other nodes the best move stored in the transposition
+	const checkers::compact_move *hashmove = nullptr;
+	if (TOP && extra.best.has_value())
+		hashmove = &extra.best.value();
+	else if (hashindex >= 0)
+		hashmove = &moves[hashindex];
+
+	const checkers::compact_move *previous = ply > 0 ? &extra.path[ply - 1] : nullptr;
+
+	int indices[G_MAXMOVES];
+	extra.ordering.order(moves, indices, turn, ply, hashmove, previous);
+
+	// the threats are only worth extending with few pieces left
+	bool endgame = std::popcount(board.get_player(turn) | board.get_player(checkers::state_flip(turn))) <= G_EXTENSION_ENDGAME;
+
+	float value = -1e9;
+	float a = alpha;
+	std::optional<checkers::compact_move> best;
+
+	bool splitting = extra.shared.mode == explorer::search_mode::YBWC
+		&& extra.shared.threads > 1
+		&& depth_remaining >= G_YBWC_MINDEPTH;
+
+	for (int k = 0; k < moves.size; ++k)
+	{
+		auto &move = moves[indices[k]];
+		// young brothers wait, once the eldest brother is searched the others are split across threads
+		if (splitting && k > 0)
 		{
-			for (auto i : indices)
+			checkers::compact_move siblings[G_MAXMOVES];
+			for (int j = k; j < moves.size; ++j)
 			{
-				auto &move = moves[i];
-
-				float newvalue = evaluate<false>(
-					board.perform_move(move, turn),
-					nextturn,
-					player,
-					depth_remaining - 1,
-					a,
-					beta,
-					false,
-					extra,
-					board.perform_move(move, turn).compute_moves(nextturn)
-				);
-
-				value = std::max(value, newvalue);
-				a = std::max(a, newvalue);
-				if (beta <= a)
-					break;
+				siblings[j - k] = moves[indices[j]];
 			}
+
+			split(board, turn, depth_remaining, ply, siblings, moves.size - k, endgame, beta, a, value, best, extra);
+			break;
+		}
+
+		bool quiet = move.length == 0;
+		int plies = extend(board, turn, move, moves.size, endgame, ply, extra.extended[ply], extra);
+		int depth = depth_remaining + plies;
+
+		// the pruned move bounds the value by the futility margin, extended moves are never pruned
+		if (futile && k > 0 && quiet && plies == 0)
+		{
+			extra.stats.futility += 1;
+			value = std::max(value, futilityvalue);
+			continue;
 		}
-	}
-	else
-	{
-		value = beta;
-		float b = beta;
 
-		for (auto i : indices)
+		float newvalue;
+		if (k == 0)
+		{
+			newvalue = search_move(board, turn, move, depth, ply, a, beta, extra);
+		}
+		else if (options.reductions && quiet && plies == 0 && depth_remaining >= G_LMR_MINDEPTH && k >= G_LMR_MINMOVE)
 		{
-			auto &move = moves[i];
-			/*int newdepth = depth_remaining - 1;
-			if (move.captures.size() > 0 && newdepth == 0)
+			// late move reductions, the later the move and the deeper the node, the shallower the scout
+			int reduction = 1;
+			if (!pvnode && depth_remaining >= G_LMR_DEEPDEPTH && k >= G_LMR_DEEPMOVE)
+				reduction += 1;
+
+			extra.stats.reductions += 1;
+			newvalue = search_move(board, turn, move, depth_remaining - reduction, ply, a, std::nextafter(a, beta), extra);
+
+			// the reduced scout beat alpha, so it is verified at full depth
+			if (newvalue > a)
 			{
-				newdepth = 1;
-			}*/
-
-			float newvalue = evaluate<false>(
-				board.perform_move(move, turn),
-				nextturn,
-				player,
-				depth_remaining - 1,
-				alpha,
-				b,
-				true,
-				extra,
-				board.perform_move(move, turn).compute_moves(nextturn)
-			);
+				extra.stats.researches += 1;
+				newvalue = search_scout(board, turn, move, depth_remaining, ply, a, beta, extra);
+			}
+		}
+		else
+		{
+			newvalue = search_scout(board, turn, move, depth, ply, a, beta, extra);
+		}
 
-			value = std::min(value, newvalue);
-			b = std::min(b, newvalue);
-			if (b <= alpha)
-				break;
+		if (newvalue > value)
+		{
+			value = newvalue;
+			best = move;
 		}
-	}
 
-	// update transposition
-	extra.lock.lock();
+		if (newvalue > a && newvalue < beta)
+			update_pv(extra.pv[ply], move, extra.pv[ply + 1]);
 
-	// add the entry if it exists
-	if (extra.transposition.count(hash) == 0)
-	{
-		extra.transposition[hash] = { depth_remaining, -1e9, 1e9, value, 4 };
-	}
-	else
-	{
-		// ignore the saving if depth is too low?
-		if (extra.transposition[hash].depth > depth_remaining)
+		// the root keeps every move found better while the iteration runs, in case it is stopped
+		if (TOP && newvalue > a && !aborted(extra))
 		{
-			extra.lock.unlock();
-			return value;
+			extra.partial = move;
+			extra.partialvalue = newvalue;
+			extra.partialline = extra.pv[ply];
+			if (extra.partialline.length == 0 || !(extra.partialline.moves[0] == move))
+			{
+				extra.partialline.moves[0] = move;
+				extra.partialline.length = 1;
+			}
 		}
 
-		extra.transposition[hash].value = value;
-		extra.transposition[hash].depth = depth_remaining;
+		a = std::max(a, newvalue);
+		if (beta <= a)
+		{
+			extra.ordering.cutoff(move, turn, ply, depth_remaining, previous);
+			break;
+		}
 	}
 
-	auto &data = extra.transposition[hash];
-	// fail low
+	// do not store the result of an aborted search
+	if (aborted(extra))
+		return 0.0f;
+
+	// a failed low root has no best move, keep the one of the last pass
+	if (TOP && best.has_value() && value > alpha)
+		extra.best = best;
+
+	// update transposition
+	explorer::bound type = explorer::bound::EXACT;
 	if (value <= alpha)
-	{
-		data.beta = value;
-	}
+		type = explorer::bound::UPPER;
+	else if (value >= beta)
+		type = explorer::bound::LOWER;
 
-	// fail within range
-	if (value > alpha && value < beta)
+	// a failed low node has no best move, keep the previous one
+	int bestindex = hashindex;
+	if (type != explorer::bound::UPPER && best.has_value())
+		bestindex = (int)(std::find(moves.begin(), moves.end(), best.value()) - moves.begin());
+
+	extra.shared.transposition.store(hash, { value, depth_remaining, type, 0, bestindex });
+
+	return value;
+}
+
+// searches the root inside an aspiration window centred on the score of the previous iteration,
+// and widens the side that failed until the score falls inside
+static float aspiration(
+	checkers::board &board,
+	checkers::state turn,
+	int depth,
+	float previous,
+	evaluate_extra &extra
+)
+{
+	float delta = G_ASPIRATION_WINDOW;
+	float low = -1e9;
+	float high = 1e9;
+	if (depth >= G_ASPIRATION_MINDEPTH && std::abs(previous) < 100.0f)
 	{
-		data.alpha = value;
-		data.beta = value;
+		low = previous - delta;
+		high = previous + delta;
 	}
 
-	// fail high
-	if (value >= beta)
+	while (true)
 	{
-		data.alpha = value;
-	}
+		float score = evaluate<true>(
+			board,
+			turn,
+			depth,
+			0,
+			low,
+			high,
+			extra
+		);
 
-	extra.lock.unlock();
+		if (aborted(extra))
+			return score;
 
-	return value;
+		delta *= 4.0f;
+		if (score <= low)
+			low = delta > 100.0f ? -1e9 : previous - delta;
+		else if (score >= high)
+			high = delta > 100.0f ? 1e9 : previous + delta;
+		else
+			return score;
+	}
 }
 
-// TODO! Fix this shit
-static float MTDF(
-	// the current board state
-	checkers::board board,
-	// the turn
+// memory-enhanced test driver, converges on the score with zero window searches starting at the guess,
+// each pass bounds the score from one side, and the transposition table keeps the earlier passes cheap
+static float mtdf(
+	checkers::board &board,
 	checkers::state turn,
-	// the player to compute score against
-	checkers::state player,
-	// depth search remaining
-	int depth_remaining,
-	// extra info
-	evaluate_extra &extra,
-	float best
+	int depth,
+	float guess,
+	evaluate_extra &extra
 )
 {
-	float g = best;
-	float upperbound = 1e9;
+	float g = guess;
 	float lowerbound = -1e9;
-	while (lowerbound + 0.00001f < upperbound)
+	float upperbound = 1e9;
+	for (int pass = 0; lowerbound < upperbound; ++pass)
 	{
-		float beta = std::max(g, lowerbound + 0.1f);
-		//std::cout << g << "," << lowerbound << "," << upperbound << std::endl;
+		// small evaluation steps and selective search can keep the passes crawling,
+		// so the bounds left are settled by a single window search
+		if (pass == G_MTDF_PASSES)
+		{
+			g = evaluate<true>(
+				board,
+				turn,
+				depth,
+				0,
+				std::nextafter(lowerbound, -1e9f),
+				std::nextafter(upperbound, 1e9f),
+				extra
+			);
+			break;
+		}
+
+		// test whether the score is at least beta
+		float beta = g == lowerbound ? std::nextafter(g, upperbound) : g;
 		g = evaluate<true>(
 			board,
 			turn,
-			player,
-			depth_remaining,
-			beta - 1.0f,
+			depth,
+			0,
+			std::nextafter(beta, lowerbound),
 			beta,
-			true,
-			extra,
-			board.compute_moves(turn)
+			extra
 		);
 
+		if (aborted(extra))
+			break;
+
 		if (g < beta)
 			upperbound = g;
 		else
@@ -515,201 +1171,401 @@ static float MTDF(
 	return g;
 }
 
+// extends the line with the best moves stored in the transposition table, up to depth moves,
+// for the zero window searches which leave the principal variation table empty,
+// and for the lines cut short by transposition table cutoffs
+static void hash_line(
+	checkers::board board,
+	checkers::state turn,
+	int depth,
+	const explorer::transpositiontable &table,
+	pv_line &line
+)
+{
+	for (int i = 0; i < line.length; ++i)
+	{
+		board = board.perform_move(line.moves[i], turn);
+		turn = checkers::state_flip(turn);
+	}
+
+	while (line.length < depth)
+	{
+		explorer::ttable data;
+		if (!table.probe(position_hash(board, turn), data) || data.move < 0)
+			break;
+
+		checkers::move_list moves;
+		board.compute_moves(turn, moves);
+		if (data.move >= moves.size)
+			break;
+
+		line.moves[line.length++] = moves[data.move];
+		board = board.perform_move(moves[data.move], turn);
+		turn = checkers::state_flip(turn);
+	}
+}
+
 
 void explorer::optimizer::compute_score(checkers::state turn, bool verbose)
 {
-	// purge transposition table entries that ran out of age
-	auto it = m_transposition.begin();
-	while (it != m_transposition.end())
+	start(turn, m_limits, verbose);
+	wait();
+}
+
+void explorer::optimizer::start(checkers::state turn, const search_limits &limits, bool verbose)
+{
+	begin(m_board, turn, limits, false, verbose);
+}
+
+void explorer::optimizer::ponder(checkers::state turn, const checkers::move &expected, const search_limits &limits, bool verbose)
+{
+	m_board = m_board.perform_move(expected, turn);
+	begin(m_board, checkers::state_flip(turn), limits, true, verbose);
+}
+
+void explorer::optimizer::ponder(checkers::state turn, const search_limits &limits, bool verbose)
+{
+	begin(m_board, turn, limits, true, verbose);
+}
+
+void explorer::optimizer::ponderhit()
+{
+	if (m_search != nullptr && m_search->pondering)
+		engage_limits(*m_search);
+}
+
+void explorer::optimizer::stop()
+{
+	if (m_search != nullptr)
+		m_search->stop = true;
+
+	wait();
+}
+
+void explorer::optimizer::wait()
+{
+	m_pool.wait();
+
+	if (m_search == nullptr || m_finished)
+		return;
+
+	m_finished = true;
+	m_nodes = m_search->nodes;
+
+	if (m_search->verbose)
 	{
-		// decrement age
-		it->second.age -= 1;
+		std::cout << "\n----- Evaluations -----" << std::endl;
 
-		// remove the element if it ran out of age
-		if (it->second.age <= 0)
-		{
-			m_transposition.erase(it++);
-		}
-		else
+		checkers::state turn = m_search->turn;
+		float sign = turn == m_player ? 1.0f : -1.0f;
+
+		checkers::move_list moves;
+		m_search->board.compute_moves(turn, moves);
+		for (int j = 0; j < moves.size; ++j)
 		{
-			++it;
+			uint64_t hash = position_hash(m_search->board.perform_move(moves[j], turn), checkers::state_flip(turn));
+			explorer::ttable data;
+			if (!m_transposition->probe(hash, data))
+				continue;
+
+			std::cout << moves[j].expand().str() << " is " << -sign * data.value << std::endl;
 		}
 	}
+}
 
-	// scores follow the definition
-	// + for red winning
-	// - for black winning
-	// the higher the |score|, the larger the advantage
-	// 0 is even
+bool explorer::optimizer::searching() const
+{
+	return m_pool.busy();
+}
 
-	/*std::random_device dev;
-	std::mt19937 rng(dev());
-	std::uniform_real_distribution<float> dist(0.0, 1.0);*/
+void explorer::optimizer::on_progress(std::function<void(const search_info &)> callback)
+{
+	stop();
+	m_progress = std::move(callback);
+}
 
+void explorer::optimizer::on_finished(std::function<void(const search_info &)> callback)
+{
+	stop();
+	m_finished_callback = std::move(callback);
+}
 
-	// set extra data
-	evaluate_extra extra{
-		{},
-		m_transposition,
+void explorer::optimizer::begin(checkers::board board, checkers::state turn, const search_limits &limits, bool pondering, bool verbose)
+{
+	// only one search runs at a time
+	stop();
+
+	// age the transposition table entries and the move ordering tables from the previous searches
+	m_transposition->new_search();
+	for (auto &ordering : m_orderings)
+	{
+		ordering->age();
+	}
+
+	// set shared data
+	m_search.reset(new search_shared{
+		*m_transposition,
+		false,
+		board,
+		turn,
+		verbose,
+		limits,
+		pondering,
+		std::chrono::steady_clock::now().time_since_epoch().count(),
 		0,
-		std::nullopt
-	};
+		0,
+		0,
+		0,
+		m_mode,
+		m_options,
+		m_pool.size(),
+		std::make_unique<work_queue[]>(m_pool.size())
+	});
+	m_search->limits.depth = limit_depth(m_search->limits.depth);
 
-	// compute moves and other temporary constants
-	auto moves = m_board.compute_moves(turn);
-	checkers::state nextturn = checkers::state_flip(turn);
-	auto hashing = checkers::board::hash_function();
+	// a ponder search has no limits until the ponderhit
+	if (!pondering)
+		engage_limits(*m_search);
 
 	if (verbose)
 		std::cout << "---- Depths ----" << std::endl;
 
 	// reset score (do not use the last iter's it will break)
 	m_score = 0;
-	// iterative deepining
-	int startdepth = 1;
-	int enddepth = 16;
-	for (int depth = startdepth; depth < enddepth; ++depth)
+	m_lines.clear();
+	m_best = std::nullopt;
+	m_nodes = 0;
+	m_qnodes = 0;
+	m_depth = 0;
+	m_stats = {};
+	m_finished = false;
+
+	m_pool.start([this](int thread) { search(thread); });
+}
+
+void explorer::optimizer::search(int thread)
+{
+	// scores follow the definition
+	// + for the optimizer's player winning
+	// - for the other player winning
+	// the higher the |score|, the larger the advantage
+	// 0 is even
+	search_shared &shared = *m_search;
+	checkers::state turn = shared.turn;
+	bool verbose = shared.verbose;
+
+	// the search scores are from the perspective of the turn moving
+	float sign = turn == m_player ? 1.0f : -1.0f;
+
+	// lazy smp, every thread runs the iterative deepening on the shared transposition table,
+	// thread 0 is the main thread whose results are kept, the helpers stop when it finishes
+	// ybwc, the main thread runs the iterative deepening, and splits nodes across the helpers
+	evaluate_extra extra{
+		shared,
+		0,
+		0,
+		0,
+		std::nullopt,
+		thread,
+		nullptr,
+		*m_orderings[thread],
+		{},
+		{},
+		{},
+		std::make_unique<pv_line[]>(G_MAXPLY + 1),
+		std::nullopt,
+		0.0f,
+		{}
+	};
+	checkers::board board = shared.board;
+	std::optional<checkers::compact_move> best;
+
+	// in ybwc, only the main thread deepens, the helpers search the siblings it splits
+	if (m_mode == search_mode::YBWC && thread != 0)
+	{
+		ybwc_helper(extra);
+		shared.nodes += extra.unreported;
+		return;
+	}
+
+	// the results of the main thread, reported to the callbacks
+	auto report = [&]()
+	{
+		search_info info;
+		info.depth = m_depth;
+		info.score = m_score;
+		info.nodes = shared.nodes + extra.unreported;
+		auto elapsed = std::chrono::steady_clock::duration(std::chrono::steady_clock::now().time_since_epoch().count() - shared.start);
+		info.seconds = std::chrono::duration<double>(elapsed).count();
+		info.line = m_lines;
+		return info;
+	};
+
+	// stagger the depths of the helpers, so they fill the table ahead of the main thread
+	int startdepth = 1 + (thread == 0 ? 0 : thread % 2);
+	float previous = 0.0f;
+
+	// a ponder search deepens to the deepest ply until the ponderhit engages the depth limit
+	for (int depth = startdepth; depth <= (shared.pondering ? G_MAXPLY - 1 : shared.limits.depth); ++depth)
 	{
 		extra.exploration = 0;
-		//if (verbose)
-		//{
-		/*	m_score = MTDF(
-				m_board,
-				turn,
-				m_player,
-				depth,
-				extra,
-				m_score
-			);*/
-		//}
-		//else
-		{
-			m_score = evaluate<true>(
-				m_board,
-				turn,
-				m_player,
-				depth,
-				-1e9,
-				1e9,
-				true,
-				extra,
-				m_board.compute_moves(turn)
-			);
-		}
+		extra.quiescence = 0;
+		extra.stats = {};
+		extra.partial = std::nullopt;
 
+		float score;
+		if (m_root == root_search::MTDF)
+			score = mtdf(board, turn, depth, previous, extra);
+		else
+			score = aspiration(board, turn, depth, previous, extra);
 
-		if (verbose && depth >= 8)
+		previous = score;
+
+		if (thread != 0)
 		{
-			std::cout << "At " << depth << ", score = " << m_score << std::endl;
-			std::cout << "  " << extra.exploration << std::endl;
-			//std::cout << "-- best line --" << std::endl;
+			if (shared.stop)
+				break;
+			continue;
 		}
 
-		// print wtf it is thinking, print the best line
-		checkers::board b = m_board;
-		checkers::state t = turn;
+		m_qnodes += extra.quiescence;
+		m_stats += extra.stats;
 
-		bool maxing = true;
-		for (int i = 0; i < depth - 1; ++i)
+		// a stopped iteration only replaces the results when it found a better move than the last one
+		if (shared.stop)
 		{
-			auto moves = b.compute_moves(t);
-			if (maxing)
+			if (extra.partial.has_value() && !(best.has_value() && extra.partial.value() == best.value()))
 			{
-				int best = -1;
-				float score = -1e9;
-				for (int j = 0; j < moves.size(); ++j)
+				m_score = sign * extra.partialvalue;
+				best = extra.partial;
+
+				m_lines.clear();
+				for (int i = 0; i < extra.partialline.length; ++i)
 				{
-					uint64_t hash = hashing(b.perform_move(moves[j], t)) ^ std::hash<bool>()(t != m_player);
-					if (extra.transposition.count(hash) == 0)
-						continue;
-
-					auto &data = extra.transposition[hash];
-					if (data.value > score)
-					{
-						best = j;
-						score = data.value;
-					}
+					m_lines.push_back(extra.partialline.moves[i].expand());
 				}
+			}
 
-				if (best == -1)
-					break;
+			if (verbose)
+				std::cout << "Stopped in depth " << depth << "\n";
+			break;
+		}
 
-				if (verbose && depth >= 8)
-					std::cout << moves[best].str() << " ";
+		m_score = sign * score;
+		best = extra.best;
+		m_depth = depth;
 
-				b = b.perform_move(moves[best], t);
-				t = checkers::state_flip(t);
-				maxing = !maxing;
-			}
-			else
-			{
-				int best = -1;
-				float score = 1e9;
-				for (int j = 0; j < moves.size(); ++j)
-				{
-					uint64_t hash = hashing(b.perform_move(moves[j], t)) ^ std::hash<bool>()(t != m_player);
-					if (extra.transposition.count(hash) == 0)
-						continue;
-
-					auto &data = extra.transposition[hash];
-					if (data.value < score)
-					{
-						best = j;
-						score = data.value;
-					}
-				}
+		if (verbose && depth >= 8)
+		{
+			std::cout << "At " << depth << ", score = " << m_score << std::endl;
+			std::cout << "  " << extra.exploration << " (" << extra.quiescence << " quiescence)" << std::endl;
+			//std::cout << "-- best line --" << std::endl;
+		}
 
-				if (best == -1)
-					break;
+		// the best line, straight from the principal variation table,
+		// completed from the transposition table where the zero windows or the table cutoffs left it short
+		if (extra.pv[0].length == 0 && extra.best.has_value())
+		{
+			extra.pv[0].moves[0] = extra.best.value();
+			extra.pv[0].length = 1;
+		}
+		hash_line(shared.board, turn, depth, *m_transposition, extra.pv[0]);
 
-				if (verbose && depth >= 8)
-					std::cout << moves[best].str() << " ";
+		m_lines.clear();
+		const pv_line &line = extra.pv[0];
+		for (int i = 0; i < line.length; ++i)
+		{
+			m_lines.push_back(line.moves[i].expand());
 
-				b = b.perform_move(moves[best], t);
-				t = checkers::state_flip(t);
-				maxing = !maxing;
-			}
+			if (verbose && depth >= 8)
+				std::cout << m_lines.back().str() << " ";
 		}
 
 		if (verbose && depth >= 8)
 			std::cout << "\n\n";
 
+		if (m_progress)
+			m_progress(report());
+
 		// exit when the score is sure
-		int limit = 100000;
-		if (abs(m_score) > 100.0f || extra.exploration > limit)
+		if (abs(m_score) > 100.0f)
 		{
-			std::cout << "Cutoff depth " << depth << "\n";
+			if (verbose)
+				std::cout << "Cutoff depth " << depth << "\n";
 			break;
 		}
+
+		// the next iteration would not finish in the time left
+		int64_t softline = shared.softline;
+		if (softline > 0 && std::chrono::steady_clock::now().time_since_epoch().count() > softline)
+			break;
 	}
 
+	shared.nodes += extra.unreported;
+	extra.unreported = 0;
+	if (thread != 0)
+		return;
 
-	// save table
-	m_transposition = extra.transposition;
+	// compute best move, a search stopped before any move was searched plays the first move
+	checkers::move_list moves;
+	shared.board.compute_moves(turn, moves);
 
-	// compute best move
-	if (verbose)
-		std::cout << "\n----- Evaluations -----" << std::endl;
+	if (best.has_value())
+		m_best = best.value().expand();
+	else if (!moves.empty())
+		m_best = moves[0].expand();
 
-	m_best = extra.best;
+	if (m_finished_callback)
+		m_finished_callback(report());
 
-	for (int j = 0; j < moves.size(); ++j)
-	{
-		uint64_t hash = hashing(m_board.perform_move(moves[j], turn)) ^ std::hash<bool>()(false);
-		if (extra.transposition.count(hash) == 0)
-			continue;
+	shared.stop = true;
+}
+
+void explorer::optimizer::update_board(checkers::board newboard)
+{
+	m_board = newboard;
+}
+
+void explorer::optimizer::set_hash_size(size_t megabytes)
+{
+	stop();
+	m_transposition->resize(megabytes);
+}
+
+void explorer::optimizer::set_threads(int threads)
+{
+	stop();
+	m_pool.resize(threads);
 
-		auto &data = extra.transposition[hash];
-		if (verbose)
-			std::cout << moves[j].str() << " is " << data.value << std::endl;
+	// keep the tables of the existing threads
+	while (m_orderings.size() < (size_t)m_pool.size())
+	{
+		m_orderings.push_back(std::make_unique<move_ordering>());
 	}
+	m_orderings.resize(m_pool.size());
+}
 
-	return;
+void explorer::optimizer::set_mode(search_mode mode)
+{
+	stop();
+	m_mode = mode;
 }
 
-void explorer::optimizer::update_board(checkers::board newboard)
+void explorer::optimizer::set_root_search(root_search root)
 {
-	m_board = newboard;
+	stop();
+	m_root = root;
+}
+
+void explorer::optimizer::set_limits(const search_limits &limits)
+{
+	m_limits = limits;
+	m_limits.depth = limit_depth(m_limits.depth);
+}
+
+void explorer::optimizer::set_options(const search_options &options)
+{
+	m_options = options;
 }
 
 float explorer::optimizer::get_score() const
@@ -726,3 +1582,23 @@ const std::optional<checkers::move> &explorer::optimizer::get_move() const
 {
 	return m_best;
 }
+
+size_t explorer::optimizer::get_nodes() const
+{
+	return m_nodes;
+}
+
+size_t explorer::optimizer::get_quiescence_nodes() const
+{
+	return m_qnodes;
+}
+
+int explorer::optimizer::get_depth() const
+{
+	return m_depth;
+}
+
+const explorer::search_stats &explorer::optimizer::get_stats() const
+{
+	return m_stats;
+}
\ No newline at end of file
@@ -1,48 +1,265 @@
 #pragma once
 
-#include <unordered_map>
 #include <optional>
+#include <memory>
+#include <cstdint>
+#include <functional>
 #include "checkers.h"
+#include "transposition.h"
+#include "threadpool.h"
+#include "ordering.h"
+
+
+// the state shared by the threads of a running search
+struct search_shared;
+
+// The deepest iteration searched by default
+#define G_MAXDEPTH (15)
+
+// The units of a ply the search extensions are measured in, so moves can be extended by a fraction of a ply
+#define G_EXTENSION_PLY (4)
 
 
 namespace explorer
 {
 
+// the parallel search strategies of the optimizer
+enum class search_mode
+{
+	// every thread runs the iterative deepening on the shared transposition table
+	LAZY_SMP,
+	// young brothers wait, the siblings of a node are split across threads after the eldest is searched
+	YBWC,
+};
+
+// the root drivers of the iterative deepening
+enum class root_search
+{
+	// principal variation search inside an aspiration window around the previous score
+	ALPHABETA,
+	// memory-enhanced test driver, zero window searches converging on the score through the transposition table
+	MTDF,
+};
+
+// the kinds of moves the search extends
+enum class extension
+{
+	// a capture of more than one piece
+	CAPTURES = 0,
+	// a man moving onto the promotion row
+	PROMOTION,
+	// the only move of the position
+	SINGLE_REPLY,
+	// a move in the endgame after which the side moving threatens a capture
+	THREAT,
+	COUNT,
+};
+
+// the linear model predicting the deep search score of a position from a shallow one, for probcut
+// deep ~ slope * shallow + intercept, with the residuals having a standard deviation of sigma
+struct probcut_model
+{
+	// the depths of the shallow and deep searches, nodes with at least deep plies left are cut
+	int shallow;
+	int deep;
+
+	float slope;
+	float intercept;
+	float sigma;
+
+	// the number of sigmas the prediction must clear beta by to cut high, and alpha by to cut low,
+	// each fitted on the residuals of its own side
+	float highthreshold;
+	float lowthreshold;
+};
+
+// the selective search techniques, each can be turned off to measure what it saves and costs
+struct search_options
+{
+	// late move reductions, late quiet moves are searched shallower and only re-searched if they beat alpha
+	bool reductions = true;
+	// futility pruning, quiet moves near the leaves are skipped when the static eval is far below alpha
+	bool futility = true;
+	// razoring, nodes near the leaves whose static eval is far below alpha drop into the quiescence search
+	bool razoring = true;
+
+	// the extension of each kind of move, in units of G_EXTENSION_PLY, 0 disables it
+	int extensions[(int)extension::COUNT] = { 2, 2, G_EXTENSION_PLY, 2 };
+	// the most extension units a single line from the root may collect
+	int extension_budget = 4 * G_EXTENSION_PLY;
+
+	// probcut, a shallow null window search predicts whether the deep search fails outside the window,
+	// the model is fitted by testing::probcut_fit
+	bool probcut = true;
+	probcut_model probcut_params = { 2, 6, 1.126f, 0.054f, 0.622f, 2.398f, 2.123f };
+
+	// internal iterative deepening, pv and expected cut nodes without a hash move search shallower for one first
+	bool iid = true;
+};
+
+// the number of times each selective search technique fired
+struct search_stats
+{
+	// the moves searched with a reduced depth, and the ones of them re-searched at full depth
+	size_t reductions = 0;
+	size_t researches = 0;
+	// the moves skipped by futility pruning
+	size_t futility = 0;
+	// the nodes cut by razoring
+	size_t razoring = 0;
+	// the nodes cut by probcut
+	size_t probcut = 0;
+	// the internal iterative deepening searches, and the ones of them that recovered a hash move
+	size_t iid = 0;
+	size_t iidmoves = 0;
+	// the moves of each kind that were extended, and the whole plies the extensions added
+	size_t extensions[(int)extension::COUNT] = {};
+	size_t extended = 0;
+
+	search_stats &operator+=(const search_stats &other)
+	{
+		reductions += other.reductions;
+		researches += other.researches;
+		futility += other.futility;
+		razoring += other.razoring;
+		probcut += other.probcut;
+		iid += other.iid;
+		iidmoves += other.iidmoves;
+		for (int i = 0; i < (int)extension::COUNT; ++i)
+		{
+			extensions[i] += other.extensions[i];
+		}
+		extended += other.extended;
+		return *this;
+	}
+};
+
+// the limits of a search, it stops at the first limit reached, 0 is no limit
+// a stopped search returns the best move of the last iteration, or of the stopped one if it found a better move
+struct search_limits
+{
+	// the deepest iteration searched, 0 searches to the deepest ply the search supports
+	int depth = G_MAXDEPTH;
+
+	// the nodes searched by all threads
+	size_t nodes = 500000;
 
-struct ttable
+	// the wall clock time of the search in milliseconds
+	int64_t movetime = 0;
+
+	// the game clock of the side moving in milliseconds, the time for the move is allocated from it,
+	// with movestogo the moves until the next time control, 0 for the rest of the game
+	int64_t time = 0;
+	int64_t increment = 0;
+	int movestogo = 0;
+};
+
+// the results of the main thread of a search, reported after each iteration it completed
+struct search_info
 {
-	// depth of search done
+	// the depth of the last completed iteration
 	int depth;
-	// lower bound
-	float alpha;
-	// upper bound
-	float beta;
-	// age of this entry (entry deleted when age <= 0)
-	float value;
-	int age;
+	// the score from the perspective of the optimizer's player
+	float score;
+	// the nodes searched by all threads so far, and the time since the search started in seconds
+	size_t nodes;
+	double seconds;
+	// the principal variation, starting with the best move
+	std::vector<checkers::move> line;
 };
-using transpositiontable = std::unordered_map<uint64_t, ttable>;
+
 
 // this is an continuous optimizer
 class optimizer
 {
 public:
-	// initialization code
-	optimizer(checkers::board board, checkers::state player);
+	// initialization code, the searches run on threads threads, defaulting to one per core
+	optimizer(checkers::board board, checkers::state player, int threads = 0);
 
-	// runs the computation of the position scores
+	// initialization code, the searches use the given transposition table, which other optimizers may share
+	optimizer(checkers::board board, checkers::state player, std::shared_ptr<transpositiontable> table, int threads = 0);
+
+	// stops the running search
+	~optimizer();
+
+	// runs the computation of the position scores under the limits set, blocking until it finished
 	// implicitly sets the values in the optimizer state
 	void compute_score(checkers::state turn, bool verbose = true);
 
+	// starts searching the board under the limits on the search threads, returning immediately,
+	// a running search is stopped first, the results are set once the search finished
+	void start(checkers::state turn, const search_limits &limits, bool verbose = false);
+
+	// starts searching the position after the expected move of the turn, the board becomes that position,
+	// the search runs without limits until ponderhit engages them, or until stop
+	void ponder(checkers::state turn, const checkers::move &expected, const search_limits &limits, bool verbose = false);
+
+	// starts searching the board itself without limits until ponderhit engages them, or until stop
+	void ponder(checkers::state turn, const search_limits &limits, bool verbose = false);
+
+	// the expected move was played, the limits of the ponder search start from now
+	void ponderhit();
+
+	// stops the running search, blocking until the threads finished and the results are set
+	void stop();
+
+	// blocks until the running search finished and the results are set, idle threads sleep
+	void wait();
+
+	// returns whether a search is running
+	bool searching() const;
+
+	// sets the callback called by the main search thread after each iteration it completed,
+	// and the callback called once it finished with the final results, before the helper threads finished,
+	// the callbacks must return quickly and must not start or stop searches
+	void on_progress(std::function<void(const search_info &)> callback);
+	void on_finished(std::function<void(const search_info &)> callback);
+
 	void update_board(checkers::board newboard);
 
+	// resizes the transposition table, losing its entries,
+	// a shared table must not be searched by any other optimizer meanwhile
+	void set_hash_size(size_t megabytes);
+
+	// sets the number of search threads, defaults to the number of cores
+	void set_threads(int threads);
+
+	// sets the parallel search strategy, defaults to lazy smp
+	void set_mode(search_mode mode);
+
+	// sets the root search driver, defaults to alpha-beta
+	void set_root_search(root_search root);
+
+	// sets the limits of the searches
+	void set_limits(const search_limits &limits);
+
+	// sets the selective search techniques used, defaults to all
+	void set_options(const search_options &options);
+
+	// the results of the last search, only valid while no search is running
 	float get_score() const;
 
-	// this is currently broken
+	// the principal variation of the last completed iteration, starting with the best move
 	const std::vector<checkers::move> &get_lines() const;
 
 	const std::optional<checkers::move> &get_move() const;
 
+	// the number of nodes all threads explored in the last search, and the depth the main thread completed
+	size_t get_nodes() const;
+	// the number of the main thread's nodes searched by the quiescence search at the horizons
+	size_t get_quiescence_nodes() const;
+	int get_depth() const;
+
+	// the counters of the selective search techniques of the main thread in the last search
+	const search_stats &get_stats() const;
+
+private:
+	// starts the search threads on the board
+	void begin(checkers::board board, checkers::state turn, const search_limits &limits, bool pondering, bool verbose);
+
+	// the iterative deepening of a search thread
+	void search(int thread);
+
 private:
 	checkers::board m_board;
 	checkers::state m_player;
@@ -52,7 +269,30 @@ private:
 	std::optional<checkers::move> m_best;
 	float m_score;
 	std::vector<checkers::move> m_lines;
-	transpositiontable m_transposition;
+	std::shared_ptr<transpositiontable> m_transposition;
+
+	// the persistent search threads
+	threadpool m_pool;
+	search_mode m_mode;
+	root_search m_root;
+	search_limits m_limits;
+	search_options m_options;
+
+	// statistics of the last search
+	size_t m_nodes;
+	size_t m_qnodes;
+	int m_depth;
+	search_stats m_stats;
+
+	// the running or last search, and whether its results were collected
+	std::unique_ptr<search_shared> m_search;
+	bool m_finished;
+
+	std::function<void(const search_info &)> m_progress;
+	std::function<void(const search_info &)> m_finished_callback;
+
+	// the move ordering tables of each search thread, kept between searches
+	std::vector<std::unique_ptr<move_ordering>> m_orderings;
 };
 
 
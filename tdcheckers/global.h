@@ -5,6 +5,13 @@
 // Constant for the partial board mask
 #define G_BOARDMASKS_SIZE (4*8)
 
+// The kinds of pieces for zobrist hashing, a piece is indexed by 2 * color + king
+#define G_ZOBRIST_REDMAN (0)
+#define G_ZOBRIST_REDKING (1)
+#define G_ZOBRIST_BLACKMAN (2)
+#define G_ZOBRIST_BLACKKING (3)
+#define G_ZOBRIST_KINDS (4)
+
 namespace global
 {
 	// Provides constant time looping of the board pieces
@@ -37,4 +44,40 @@ namespace global
 		uint64_t masks[G_BOARDMASKS_SIZE];
 		size_t size = G_BOARDMASKS_SIZE;
 	};
-}
\ No newline at end of file
+
+	// Provides the random keys for zobrist hashing of the board
+	// Usage:
+	//		static constexpr auto keys = zobrist();
+	//      hash ^= keys.pieces[G_ZOBRIST_REDMAN][square];
+	struct zobrist
+	{
+		constexpr zobrist() : pieces(), side(0)
+		{
+			// splitmix64, fixed seed so the keys are the same on every run
+			uint64_t state = 0x2545f4914f6cdd1dull;
+			auto next = [&state]()
+			{
+				uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+				return z ^ (z >> 31);
+			};
+
+			for (int kind = 0; kind < G_ZOBRIST_KINDS; ++kind)
+			{
+				for (int i = 0; i < G_CHECKERS_SIZE; ++i)
+				{
+					pieces[kind][i] = next();
+				}
+			}
+
+			side = next();
+		}
+
+		// the keys of each kind of piece on each square
+		uint64_t pieces[G_ZOBRIST_KINDS][G_CHECKERS_SIZE];
+
+		// the key of black to move
+		uint64_t side;
+	};
+}
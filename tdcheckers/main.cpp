@@ -1,7 +1,14 @@
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
 #include "checkers.h"
 #include "tester.h"
+#include "uci.h"
+#include "server.h"
+#include "tablebase.h"
 #include "explorer.h"
 
 
@@ -247,4 +254,125 @@ int fmain()
 	checkers::board board{position};
 	testing::analyze(board, checkers::state::BLACK);
 	return 0;
-}
\ No newline at end of file
+}
+
+// reads the position of the arguments from i, board <64 squares> <r|b>, the start position with red to move if none
+static bool read_position(const std::vector<std::string> &args, size_t i, checkers::board &board, checkers::state &turn)
+{
+	board = checkers::board{};
+	turn = checkers::state::RED;
+	if (i == args.size())
+		return true;
+
+	if (i + 3 != args.size() || args[i] != "board" || args[i + 1].size() != G_CHECKERS_SIZE)
+		return false;
+
+	board = checkers::board(args[i + 1]);
+	turn = args[i + 2] == "b" ? checkers::state::BLACK : checkers::state::RED;
+	return true;
+}
+
+static int usage()
+{
+	std::cout << "usage: tdcheckers [mode]\n"
+		"  perft <depth> [threads] [board <64 squares> <r|b>]   counts the leaf nodes of the position\n"
+		"  divide <depth> [board <64 squares> <r|b>]            counts the leaf nodes after each move\n"
+		"  perftbench [threads] [hash mb]                        runs the perft benchmark\n"
+		"  uci                                                   speaks the uci protocol on stdin and stdout\n"
+		"  server [workers] [socket path]                        serves the requests of stdin, or of the socket clients\n"
+		"  tablebase <pieces> <file> [threads]                   generates the endgame tables and saves them to the file\n"
+		"without a mode the analysis of fmain runs" << std::endl;
+	return 1;
+}
+
+// the command line tools, the position defaults to the start position
+int main(int argc, char **argv)
+{
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.empty())
+		return fmain();
+
+	const std::string &mode = args[0];
+	checkers::board board;
+	checkers::state turn;
+	try
+	{
+		if (mode == "perft" && args.size() >= 2)
+		{
+			int depth = std::stoi(args[1]);
+			size_t i = 2;
+			int threads = 1;
+			if (i < args.size() && args[i] != "board")
+				threads = std::stoi(args[i++]);
+
+			if (!read_position(args, i, board, turn))
+				return usage();
+
+			auto start = std::chrono::steady_clock::now();
+			uint64_t nodes = threads > 1 ? testing::perft_parallel(board, turn, depth, threads) : testing::perft(board, turn, depth);
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "perft " << depth << ": " << nodes << " nodes, " << elapsed << "s, "
+				<< (uint64_t)(nodes / std::max(elapsed, 1e-9)) << " nodes/s" << std::endl;
+			return 0;
+		}
+
+		if (mode == "divide" && args.size() >= 2)
+		{
+			if (!read_position(args, 2, board, turn))
+				return usage();
+
+			testing::divide(board, turn, std::stoi(args[1]));
+			return 0;
+		}
+
+		if (mode == "uci")
+		{
+			uci::uci engine;
+			uci::attach(engine);
+			return 0;
+		}
+
+		if (mode == "server")
+		{
+			server::server server(args.size() > 1 ? std::stoi(args[1]) : 0);
+			if (args.size() < 3)
+			{
+				server::serve(server);
+				return 0;
+			}
+
+			server::listener listener(server);
+			if (!listener.listen(args[2]))
+			{
+				std::cout << "cannot listen on " << args[2] << std::endl;
+				return 1;
+			}
+
+			return 0;
+		}
+
+		if (mode == "tablebase" && args.size() >= 3)
+		{
+			tablebase::tablebase tablebase;
+			tablebase.generate(std::stoi(args[1]), args.size() > 3 ? std::stoi(args[3]) : 0);
+			if (!tablebase.save(args[2]))
+			{
+				std::cout << "cannot save to " << args[2] << std::endl;
+				return 1;
+			}
+
+			return 0;
+		}
+
+		if (mode == "perftbench")
+		{
+			testing::perft_benchmark(args.size() > 1 ? std::stoi(args[1]) : 1, args.size() > 2 ? std::stoull(args[2]) : 0);
+			return 0;
+		}
+	}
+	catch (const std::exception &)
+	{
+	}
+
+	return usage();
+}
@@ -0,0 +1,130 @@
+#include "ordering.h"
+
+#include <cstring>
+
+
+// the ordering score bands, the history of a quiet move stays below G_ORDER_COUNTER
+#define G_ORDER_HASH (1 << 30)
+#define G_ORDER_CAPTURE (1 << 28)
+#define G_ORDER_KILLER (1 << 26)
+#define G_ORDER_COUNTER (1 << 25)
+
+// the history is halved once an entry reaches this value
+#define G_HISTORY_MAX (1 << 24)
+
+
+// halves every entry of the history
+static void halve_history(int (&history)[2][G_CHECKERS_SIZE][G_CHECKERS_SIZE])
+{
+	for (auto &side : history)
+	{
+		for (auto &from : side)
+		{
+			for (auto &to : from)
+			{
+				to /= 2;
+			}
+		}
+	}
+}
+
+explorer::move_ordering::move_ordering()
+{
+	clear();
+}
+
+void explorer::move_ordering::clear()
+{
+	std::memset(m_haskillers, 0, sizeof(m_haskillers));
+	std::memset(m_countermoves, 0, sizeof(m_countermoves));
+	std::memset(m_history, 0, sizeof(m_history));
+}
+
+void explorer::move_ordering::age()
+{
+	halve_history(m_history);
+
+	// killers are only meaningful for the plies of the same search
+	std::memset(m_haskillers, 0, sizeof(m_haskillers));
+}
+
+void explorer::move_ordering::order(
+	const checkers::move_list &moves,
+	int *indices,
+	checkers::state turn,
+	int ply,
+	const checkers::compact_move *hashmove,
+	const checkers::compact_move *previous
+) const
+{
+	int side = turn == checkers::state::RED ? 0 : 1;
+
+	uint16_t counter = 0;
+	if (previous != nullptr)
+		counter = m_countermoves[1 - side][previous->from][previous->to];
+
+	int scores[G_MAXMOVES];
+	for (int i = 0; i < moves.size; ++i)
+	{
+		const checkers::compact_move &move = moves[i];
+		int score;
+
+		if (hashmove != nullptr && move == *hashmove)
+			score = G_ORDER_HASH;
+		else if (move.length > 0)
+			score = G_ORDER_CAPTURE + move.length;
+		else if (m_haskillers[ply][0] && move == m_killers[ply][0])
+			score = G_ORDER_KILLER + 1;
+		else if (m_haskillers[ply][1] && move == m_killers[ply][1])
+			score = G_ORDER_KILLER;
+		else if (counter == move.from * G_CHECKERS_SIZE + move.to + 1)
+			score = G_ORDER_COUNTER;
+		else
+			score = m_history[side][move.from][move.to];
+
+		// insertion sort, move lists are short
+		int j = i;
+		while (j > 0 && scores[j - 1] < score)
+		{
+			scores[j] = scores[j - 1];
+			indices[j] = indices[j - 1];
+			j -= 1;
+		}
+
+		scores[j] = score;
+		indices[j] = i;
+	}
+}
+
+void explorer::move_ordering::cutoff(
+	const checkers::compact_move &move,
+	checkers::state turn,
+	int ply,
+	int depth,
+	const checkers::compact_move *previous
+)
+{
+	// captures are already ordered first
+	if (move.length > 0)
+		return;
+
+	int side = turn == checkers::state::RED ? 0 : 1;
+
+	// killers, most recent first
+	if (!(m_haskillers[ply][0] && move == m_killers[ply][0]))
+	{
+		m_killers[ply][1] = m_killers[ply][0];
+		m_haskillers[ply][1] = m_haskillers[ply][0];
+		m_killers[ply][0] = move;
+		m_haskillers[ply][0] = true;
+	}
+
+	if (previous != nullptr)
+		m_countermoves[1 - side][previous->from][previous->to] = move.from * G_CHECKERS_SIZE + move.to + 1;
+
+	// deeper cutoffs are worth more
+	int &history = m_history[side][move.from][move.to];
+	history += depth * depth;
+	if (history >= G_HISTORY_MAX)
+		halve_history(m_history);
+}
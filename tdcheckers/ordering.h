@@ -0,0 +1,64 @@
+#pragma once
+
+#include "checkers.h"
+
+
+// The maximum search depth in plies, bounds the per ply tables
+#define G_MAXPLY (128)
+
+
+namespace explorer
+{
+
+// Orders the moves of a search node, best first, without making the moves or probing the transposition table
+//   1. the hash move
+//   2. captures, by the number of pieces captured
+//   3. the killer moves of the ply
+//   4. the countermove of the previous move
+//   5. the remaining quiet moves, by their history
+// one instance per search thread, the tables are updated on beta cutoffs
+class move_ordering
+{
+public:
+	move_ordering();
+
+	// forgets all killers, countermoves and history
+	void clear();
+
+	// halves the history and forgets the killers, so the next search prefers fresh information
+	void age();
+
+	// fills indices with the indices of the moves, best first
+	//   hashmove is the best move stored for the position, or nullptr
+	//   previous is the move leading to the position, or nullptr
+	void order(
+		const checkers::move_list &moves,
+		int *indices,
+		checkers::state turn,
+		int ply,
+		const checkers::compact_move *hashmove,
+		const checkers::compact_move *previous
+	) const;
+
+	// records a move that caused a beta cutoff at depth remaining
+	void cutoff(
+		const checkers::compact_move &move,
+		checkers::state turn,
+		int ply,
+		int depth,
+		const checkers::compact_move *previous
+	);
+
+private:
+	// the two most recent quiet cutoff moves of each ply
+	checkers::compact_move m_killers[G_MAXPLY][2];
+	bool m_haskillers[G_MAXPLY][2];
+
+	// the quiet cutoff move replying to each (side, from, to), stored as from * 64 + to + 1, 0 if none
+	uint16_t m_countermoves[2][G_CHECKERS_SIZE][G_CHECKERS_SIZE];
+
+	// the butterfly history of the quiet cutoff moves of each (side, from, to)
+	int m_history[2][G_CHECKERS_SIZE][G_CHECKERS_SIZE];
+};
+
+}
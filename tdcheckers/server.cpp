@@ -0,0 +1,585 @@
+#include "server.h"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "uci.h"
+
+
+server::server::server(int workers, size_t megabytes)
+	: m_transposition(std::make_shared<explorer::transpositiontable>(megabytes)), m_workers(), m_lock(), m_wake(), m_idle(),
+	m_queue(), m_busy(0), m_exit(false)
+{
+	if (workers <= 0)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+
+	// every worker searches on a single thread, the requests are the parallelism
+	for (int i = 0; i < workers; ++i)
+	{
+		auto worker = std::make_unique<server::worker>();
+		worker->optimizer = std::make_unique<explorer::optimizer>(checkers::board{}, checkers::state::RED, m_transposition, 1);
+
+		server::worker &self = *worker;
+		worker->optimizer->on_progress([this, &self](const explorer::search_info &info) { progress(self, info); });
+		worker->optimizer->on_finished([this, &self](const explorer::search_info &info) { finished(self, info); });
+
+		m_workers.push_back(std::move(worker));
+	}
+
+	for (auto &worker : m_workers)
+	{
+		server::worker &self = *worker;
+		worker->thread = std::thread([this, &self]() { work(self); });
+	}
+}
+
+server::server::~server()
+{
+	std::deque<std::shared_ptr<job>> queued;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_exit = true;
+		std::swap(queued, m_queue);
+
+		for (auto &worker : m_workers)
+		{
+			if (worker->current != nullptr)
+				worker->current->cancelled = true;
+		}
+	}
+	m_wake.notify_all();
+
+	for (auto &job : queued)
+	{
+		job->request.out("result " + job->request.id + " cancelled");
+	}
+
+	for (auto &worker : m_workers)
+	{
+		worker->thread.join();
+	}
+}
+
+void server::server::submit(request request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto queued = std::make_shared<job>();
+		queued->request = std::move(request);
+		m_queue.push_back(std::move(queued));
+	}
+	m_wake.notify_all();
+}
+
+bool server::server::cancel(const std::string &id, int client)
+{
+	std::vector<std::shared_ptr<job>> removed;
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto matches = [&](const std::shared_ptr<job> &job) { return job->request.id == id && job->request.client == client; };
+
+		// queued requests are answered here, running ones by their worker once its search stopped
+		for (auto &job : m_queue)
+		{
+			if (matches(job))
+				removed.push_back(job);
+		}
+		m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), matches), m_queue.end());
+
+		for (auto &worker : m_workers)
+		{
+			if (worker->current != nullptr && matches(worker->current))
+			{
+				worker->current->cancelled = true;
+				found = true;
+			}
+		}
+	}
+	m_wake.notify_all();
+	m_idle.notify_all();
+
+	for (auto &job : removed)
+	{
+		job->request.out("result " + id + " cancelled");
+	}
+
+	return found || !removed.empty();
+}
+
+void server::server::cancel_client(int client)
+{
+	std::vector<std::string> ids;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (auto &job : m_queue)
+		{
+			if (job->request.client == client)
+				ids.push_back(job->request.id);
+		}
+
+		for (auto &worker : m_workers)
+		{
+			if (worker->current != nullptr && worker->current->request.client == client)
+				ids.push_back(worker->current->request.id);
+		}
+	}
+
+	for (auto &id : ids)
+	{
+		cancel(id, client);
+	}
+}
+
+void server::server::drain()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_idle.wait(lock, [this]() { return m_queue.empty() && m_busy == 0; });
+}
+
+void server::server::handle(const std::string &command, const reply &out, int client)
+{
+	std::vector<std::string> tokens = uci::tokenize(command);
+	if (tokens.empty())
+		return;
+
+	const std::string &name = tokens[0];
+	if (name == "isready")
+	{
+		out("readyok");
+		return;
+	}
+
+	if (tokens.size() < 2 || (name != "go" && name != "cancel"))
+	{
+		out("error - unknown command " + command);
+		return;
+	}
+
+	const std::string &id = tokens[1];
+	if (name == "cancel")
+	{
+		if (!cancel(id, client))
+			out("error " + id + " unknown request");
+		return;
+	}
+
+	request request;
+	request.id = id;
+	request.client = client;
+	request.out = out;
+
+	size_t i = 2;
+	uci::setup position;
+	std::optional<std::string> error = uci::read_position(tokens, i, position);
+	if (error.has_value())
+	{
+		out("error " + id + " " + error.value());
+		return;
+	}
+
+	request.board = position.board;
+	request.turn = position.turn;
+
+	// the limits given replace the defaults, which apply to a request without any
+	request.limits.nodes = 0;
+	bool given = false;
+	try
+	{
+		for (; i + 1 < tokens.size(); i += 2)
+		{
+			long long value = std::stoll(tokens[i + 1]);
+			const std::string &token = tokens[i];
+			if (token == "depth")
+				request.limits.depth = (int)value;
+			else if (token == "nodes")
+				request.limits.nodes = value;
+			else if (token == "movetime")
+				request.limits.movetime = value;
+			else if (token == "deadline")
+			{
+				request.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(value);
+				continue;
+			}
+			else
+			{
+				out("error " + id + " unknown limit " + token);
+				return;
+			}
+
+			given = true;
+		}
+	}
+	catch (const std::exception &)
+	{
+		out("error " + id + " invalid limits");
+		return;
+	}
+
+	if (i < tokens.size())
+	{
+		out("error " + id + " missing value of " + tokens[i]);
+		return;
+	}
+
+	if (!given)
+		request.limits = explorer::search_limits{};
+
+	submit(std::move(request));
+}
+
+void server::server::work(worker &worker)
+{
+	while (true)
+	{
+		std::shared_ptr<job> current;
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_wake.wait(lock, [this]() { return m_exit || !m_queue.empty(); });
+			if (m_exit)
+				return;
+
+			current = m_queue.front();
+			m_queue.pop_front();
+			worker.current = current;
+			m_busy += 1;
+		}
+
+		const request &request = current->request;
+		explorer::search_limits limits = request.limits;
+
+		// the time left until the deadline caps the move time
+		bool expired = false;
+		if (request.deadline.has_value())
+		{
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(request.deadline.value() - std::chrono::steady_clock::now()).count();
+			expired = left <= 0;
+			limits.movetime = limits.movetime > 0 ? std::min<int64_t>(limits.movetime, left) : left;
+		}
+
+		if (expired)
+		{
+			request.out("result " + request.id + " expired");
+		}
+		else
+		{
+			worker.optimizer->update_board(request.board);
+			worker.optimizer->start(request.turn, limits);
+
+			// sleep until the search finished, or the request was cancelled
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_wake.wait(lock, [&]() { return current->finished || current->cancelled; });
+			}
+
+			// stops a cancelled search, which still replies through finished
+			worker.optimizer->stop();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			worker.current = nullptr;
+			m_busy -= 1;
+		}
+		m_idle.notify_all();
+	}
+}
+
+void server::server::progress(worker &worker, const explorer::search_info &info)
+{
+	// the optimizers score from the perspective of red
+	const request &request = worker.current->request;
+	float score = request.turn == checkers::state::RED ? info.score : -info.score;
+
+	std::ostringstream line;
+	line << "info " << request.id << " depth " << info.depth << " score " << uci::score_text(score);
+	line << " nodes " << info.nodes << " time " << (size_t)(info.seconds * 1000.0);
+
+	if (!info.line.empty())
+	{
+		line << " pv";
+		for (auto &move : info.line)
+		{
+			line << " " << move.str();
+		}
+	}
+
+	request.out(line.str());
+}
+
+void server::server::finished(worker &worker, const explorer::search_info &info)
+{
+	std::shared_ptr<job> current = worker.current;
+	const request &request = current->request;
+
+	bool cancelled;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		cancelled = current->cancelled;
+	}
+
+	if (cancelled)
+	{
+		request.out("result " + request.id + " cancelled");
+	}
+	else
+	{
+		// the best move is set on this thread before the callback
+		const std::optional<checkers::move> &best = worker.optimizer->get_move();
+		float score = request.turn == checkers::state::RED ? info.score : -info.score;
+
+		std::ostringstream line;
+		line << "result " << request.id << " bestmove " << (best.has_value() ? best.value().str() : "none");
+		line << " score " << uci::score_text(score) << " depth " << info.depth;
+		line << " nodes " << info.nodes << " time " << (size_t)(info.seconds * 1000.0);
+
+		if (!info.line.empty())
+		{
+			line << " pv";
+			for (auto &move : info.line)
+			{
+				line << " " << move.str();
+			}
+		}
+
+		request.out(line.str());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		current->finished = true;
+	}
+	m_wake.notify_all();
+}
+
+void server::serve(server &server)
+{
+	std::mutex output;
+	reply out = [&output](const std::string &line)
+	{
+		std::lock_guard<std::mutex> lock(output);
+		std::cout << line << std::endl;
+	};
+
+	std::string command;
+	while (std::getline(std::cin, command))
+	{
+		server.handle(command, out);
+	}
+
+	server.drain();
+}
+
+#ifndef _WIN32
+
+// a connected client, closed once its last pending reply is gone
+struct connection
+{
+	int fd;
+	std::mutex lock;
+	bool open = true;
+
+	connection(int fd) : fd(fd), lock() {}
+
+	~connection()
+	{
+		close(fd);
+	}
+
+	// writes a line, dropping it once the client went away
+	void write(const std::string &line)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		std::string text = line + "\n";
+		size_t written = 0;
+		while (open && written < text.size())
+		{
+			ssize_t n = send(fd, text.data() + written, text.size() - written, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR)
+				continue;
+
+			if (n <= 0)
+				open = false;
+			else
+				written += (size_t)n;
+		}
+	}
+};
+
+#endif
+
+server::listener::listener(server &server)
+	: m_server(server), m_lock(), m_fd(-1), m_clients(), m_stopped(false)
+{}
+
+server::listener::~listener()
+{
+	stop();
+}
+
+bool server::listener::listen(const std::string &path)
+{
+#ifdef _WIN32
+	return false;
+#else
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+		return false;
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+
+	// a stale socket of an earlier server is replaced
+	unlink(path.c_str());
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_stopped)
+		{
+			close(fd);
+			return true;
+		}
+		m_fd = fd;
+	}
+
+	// the clients are numbered from 1, 0 is the client of serve
+	int clients = 0;
+	while (true)
+	{
+		int peer = accept(fd, nullptr, nullptr);
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_stopped)
+		{
+			if (peer >= 0)
+				close(peer);
+			break;
+		}
+
+		if (peer < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+
+		// the clients that disconnected are joined as new ones arrive
+		for (auto it = m_clients.begin(); it != m_clients.end();)
+		{
+			if (!it->done)
+			{
+				++it;
+				continue;
+			}
+
+			it->thread.join();
+			it = m_clients.erase(it);
+		}
+
+		client &self = m_clients.emplace_back();
+		self.fd = peer;
+		int id = ++clients;
+		self.thread = std::thread([this, &self, id]() { serve_client(self, id); });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_fd = -1;
+	}
+	close(fd);
+	return true;
+#endif
+}
+
+void server::listener::stop()
+{
+	std::list<client> clients;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stopped = true;
+
+#ifndef _WIN32
+		// wakes the accept, and the reads of the clients still connected, which can still write their cancelled requests,
+		// the socket is closed by listen, and the connections by their last replies
+		if (m_fd >= 0)
+			shutdown(m_fd, SHUT_RDWR);
+
+		for (auto &client : m_clients)
+		{
+			if (!client.done)
+				shutdown(client.fd, SHUT_RD);
+		}
+#endif
+
+		std::swap(clients, m_clients);
+	}
+
+	for (auto &client : clients)
+	{
+		client.thread.join();
+	}
+}
+
+#ifndef _WIN32
+
+void server::listener::serve_client(client &self, int id)
+{
+	auto peer = std::make_shared<connection>(self.fd);
+	reply out = [peer](const std::string &line) { peer->write(line); };
+
+	std::string buffer;
+	char chunk[4096];
+	while (true)
+	{
+		ssize_t n = recv(self.fd, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+
+		buffer.append(chunk, (size_t)n);
+
+		size_t end;
+		while ((end = buffer.find('\n')) != std::string::npos)
+		{
+			std::string command = buffer.substr(0, end);
+			buffer.erase(0, end + 1);
+			if (!command.empty() && command.back() == '\r')
+				command.pop_back();
+
+			m_server.handle(command, out, id);
+		}
+	}
+
+	// nobody is left to read the results
+	m_server.cancel_client(id);
+
+	// the socket stays open until the last reply is gone, after which stop must not touch it
+	std::lock_guard<std::mutex> lock(m_lock);
+	self.done = true;
+}
+
+#else
+
+void server::listener::serve_client(client &, int)
+{}
+
+#endif
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <memory>
+#include <chrono>
+
+#include "checkers.h"
+#include "explorer.h"
+
+
+// The default size of the transposition table shared by the workers in megabytes
+#define G_SERVER_HASH_MB (512)
+
+namespace server
+{
+	// receives the result lines of a request, called from the worker threads
+	using reply = std::function<void(const std::string &)>;
+
+	// a position to analyze under the limits
+	struct request
+	{
+		std::string id;
+		// the client the request came from, the ids are only unique per client
+		int client = 0;
+		checkers::board board;
+		checkers::state turn = checkers::state::RED;
+		explorer::search_limits limits;
+		// when the request must be answered by, including the time it waits in the queue
+		std::optional<std::chrono::steady_clock::time_point> deadline;
+		reply out;
+	};
+
+	/**
+	 * @brief Analyzes requests on a fixed pool of single threaded optimizers sharing one transposition table
+	 *
+	 * a line based protocol, one command per line
+	 *
+	 *   go <id> <startpos|board <64 squares> <r|b>> [moves <move>...] [depth <n>] [nodes <n>] [movetime <ms>] [deadline <ms>]
+	 *       queues the position, the deadline counts from now, it cuts the search short, and drops the request once it expired in the queue,
+	 *       replies info <id> depth <n> score <score> nodes <n> time <ms> pv <move>... after each iteration,
+	 *       then one of result <id> bestmove <move> score <score> depth <n> nodes <n> time <ms> pv <move>...,
+	 *       result <id> cancelled or result <id> expired
+	 *   cancel <id>     cancels the queued or running request
+	 *   isready         answers readyok
+	 *
+	 * the scores as in uci, errors are replied as error <id> <message>
+	*/
+	class server
+	{
+	public:
+		// starts the workers, defaulting to one per core
+		server(int workers = 0, size_t megabytes = G_SERVER_HASH_MB);
+
+		// cancels the queued and running requests, and stops the workers
+		~server();
+
+		// queues the request, the first idle worker takes it
+		void submit(request request);
+
+		// cancels the queued or running requests of the id from the client, returns whether any was found
+		bool cancel(const std::string &id, int client = 0);
+
+		// cancels all queued and running requests of the client
+		void cancel_client(int client);
+
+		// blocks until the queue is empty and every worker is idle
+		void drain();
+
+		// handles a command of the protocol from the client, replying to out
+		void handle(const std::string &command, const reply &out, int client = 0);
+
+	private:
+		// a request queued or being searched
+		struct job
+		{
+			::server::request request;
+			bool cancelled = false;
+			bool finished = false;
+		};
+
+		struct worker
+		{
+			std::unique_ptr<explorer::optimizer> optimizer;
+			std::shared_ptr<job> current;
+			std::thread thread;
+		};
+
+		// the loop of a worker thread
+		void work(worker &worker);
+
+		// the callbacks of the optimizer of the worker, called on its search thread
+		void progress(worker &worker, const explorer::search_info &info);
+		void finished(worker &worker, const explorer::search_info &info);
+
+	private:
+		std::shared_ptr<explorer::transpositiontable> m_transposition;
+		std::vector<std::unique_ptr<worker>> m_workers;
+
+		// guards the queue, the jobs and the current jobs of the workers
+		std::mutex m_lock;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		std::deque<std::shared_ptr<job>> m_queue;
+		int m_busy;
+		bool m_exit;
+	};
+
+
+	// serves the commands of stdin, replying to stdout, until the end of the input, then waits for the requests
+	void serve(server &server);
+
+
+	/**
+	 * @brief Serves the clients connecting to a unix domain socket, each connection a stream of commands
+	 *
+	 * every connection is read on a thread of its own, the requests of a connection are cancelled when it closes,
+	 * the listener must be stopped or destroyed before its server
+	 * note: not available on windows, where listen returns false
+	*/
+	class listener
+	{
+	public:
+		listener(server &server);
+
+		// stops listening, and joins the clients
+		~listener();
+
+		// accepts the clients of the socket at the path until stop, blocking,
+		// returns false if the socket cannot be opened
+		bool listen(const std::string &path);
+
+		// closes the socket and the connections, cancelling their requests, and joins the client threads,
+		// called from any thread, a stopped listener does not listen again
+		void stop();
+
+	private:
+		struct client
+		{
+			std::thread thread;
+			int fd;
+			bool done = false;
+		};
+
+		// reads the commands of the client until it disconnects or the listener stops
+		void serve_client(client &client, int id);
+
+	private:
+		server &m_server;
+
+		// guards the socket, the clients and whether the listener stopped
+		std::mutex m_lock;
+		int m_fd;
+		std::list<client> m_clients;
+		bool m_stopped;
+	};
+}
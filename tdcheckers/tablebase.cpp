@@ -0,0 +1,457 @@
+#include "tablebase.h"
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <bit>
+
+#include "global.h"
+
+
+// the number of dark squares, and the dark squares a man can stand on, without its promotion row
+#define G_TABLEBASE_SQUARES (32)
+#define G_TABLEBASE_MANSQUARES (28)
+
+// the result bits of an entry still being solved
+#define G_TABLEBASE_UNKNOWN (3)
+
+// the flags of the moves left of a position being solved, over the number of its moves within the material
+#define G_TABLEBASE_WINNING (0x40)
+#define G_TABLEBASE_DRAWING (0x80)
+#define G_TABLEBASE_COUNT (0x3f)
+
+
+// the binomial coefficients up to the number of dark squares
+struct binomials
+{
+	constexpr binomials() : values()
+	{
+		for (int n = 0; n <= G_TABLEBASE_SQUARES; ++n)
+		{
+			values[n][0] = 1;
+			for (int k = 1; k <= n; ++k)
+			{
+				values[n][k] = values[n - 1][k - 1] + (k < n ? values[n - 1][k] : 0);
+			}
+		}
+	}
+
+	uint64_t values[G_TABLEBASE_SQUARES + 1][G_TABLEBASE_SQUARES + 1];
+};
+
+static constexpr auto choose = binomials();
+static constexpr auto squares = global::boardmask();
+
+// the dark square of each square index, -1 for the light squares
+struct dark_squares
+{
+	constexpr dark_squares() : index()
+	{
+		for (int i = 0; i < G_CHECKERS_SIZE; ++i)
+		{
+			index[i] = -1;
+		}
+
+		for (int i = 0; i < G_TABLEBASE_SQUARES; ++i)
+		{
+			index[std::countr_zero(squares.masks[i])] = i;
+		}
+	}
+
+	int index[G_CHECKERS_SIZE];
+};
+
+static constexpr auto dark = dark_squares();
+
+// the kinds of pieces in the order of the index, and the first dark square and the number of dark squares each can stand on,
+// the dark squares are in the order of the square indices, so the red men leave out row 0 and the black men row 7
+static constexpr int kind_offset[4] = { G_TABLEBASE_SQUARES - G_TABLEBASE_MANSQUARES, 0, 0, 0 };
+static constexpr int kind_squares[4] = { G_TABLEBASE_MANSQUARES, G_TABLEBASE_SQUARES, G_TABLEBASE_MANSQUARES, G_TABLEBASE_SQUARES };
+
+static void material_counts(const tablebase::material &m, int counts[4])
+{
+	counts[0] = m.redmen;
+	counts[1] = m.redkings;
+	counts[2] = m.blackmen;
+	counts[3] = m.blackkings;
+}
+
+static tablebase::material material_of(const checkers::board &board)
+{
+	uint64_t redkings = board.get_kings(checkers::state::RED);
+	uint64_t blackkings = board.get_kings(checkers::state::BLACK);
+	return {
+		std::popcount(board.get_player(checkers::state::RED) & ~redkings),
+		std::popcount(redkings),
+		std::popcount(board.get_player(checkers::state::BLACK) & ~blackkings),
+		std::popcount(blackkings)
+	};
+}
+
+// the number of positions of the material, every placement of each kind of piece with each side to move,
+// including the placements where pieces overlap
+static uint64_t material_size(const tablebase::material &m)
+{
+	int counts[4];
+	material_counts(m, counts);
+
+	uint64_t size = 2;
+	for (int kind = 0; kind < 4; ++kind)
+	{
+		size *= choose.values[kind_squares[kind]][counts[kind]];
+	}
+
+	return size;
+}
+
+// the index of the position in the table of its material, each kind of piece is ranked in the combinatorial number system
+static uint64_t position_index(const tablebase::material &m, const checkers::board &board, checkers::state turn)
+{
+	int counts[4];
+	material_counts(m, counts);
+
+	uint64_t redkings = board.get_kings(checkers::state::RED);
+	uint64_t blackkings = board.get_kings(checkers::state::BLACK);
+	uint64_t pieces[4] = {
+		board.get_player(checkers::state::RED) & ~redkings,
+		redkings,
+		board.get_player(checkers::state::BLACK) & ~blackkings,
+		blackkings
+	};
+
+	uint64_t index = 0;
+	for (int kind = 0; kind < 4; ++kind)
+	{
+		uint64_t rank = 0;
+		uint64_t bits = pieces[kind];
+		for (int k = 1; bits; ++k)
+		{
+			int square = dark.index[std::countr_zero(bits)] - kind_offset[kind];
+			bits &= bits - 1;
+
+			rank += choose.values[square][k];
+		}
+
+		index = index * choose.values[kind_squares[kind]][counts[kind]] + rank;
+	}
+
+	return index * 2 + (turn == checkers::state::BLACK);
+}
+
+// the position of the index in the table of its material, returns false when pieces overlap
+static bool position_board(const tablebase::material &m, uint64_t index, checkers::board &board, checkers::state &turn)
+{
+	int counts[4];
+	material_counts(m, counts);
+
+	turn = (index & 1) ? checkers::state::BLACK : checkers::state::RED;
+	index /= 2;
+
+	uint64_t pieces[4] = {};
+	uint64_t occupied = 0;
+	for (int kind = 3; kind >= 0; --kind)
+	{
+		uint64_t size = choose.values[kind_squares[kind]][counts[kind]];
+		uint64_t rank = index % size;
+		index /= size;
+
+		// the largest square whose coefficient fits, from the highest piece down
+		int square = kind_squares[kind] - 1;
+		for (int k = counts[kind]; k > 0; --k)
+		{
+			while (choose.values[square][k] > rank)
+				square -= 1;
+
+			rank -= choose.values[square][k];
+			uint64_t mask = squares.masks[square + kind_offset[kind]];
+			if (occupied & mask)
+				return false;
+
+			pieces[kind] |= mask;
+			occupied |= mask;
+			square -= 1;
+		}
+	}
+
+	board = checkers::board(pieces[0] | pieces[1], pieces[2] | pieces[3], pieces[1] | pieces[3]);
+	return true;
+}
+
+static uint16_t pack_entry(int result, int distance)
+{
+	return (uint16_t)((distance << 2) | result);
+}
+
+
+tablebase::tablebase::tablebase()
+	: m_pieces(0), m_tables()
+{}
+
+void tablebase::tablebase::generate(int pieces, int threads, bool verbose)
+{
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	m_pieces = std::max(pieces, 1);
+	size_t base = m_pieces + 1;
+	m_tables.assign(base * base * base * base, {});
+
+	// a capture leads to fewer pieces, and a promotion to fewer men,
+	// so the materials with the same number of pieces and men only reach the solved ones, and are solved in parallel
+	for (int total = 1; total <= m_pieces; ++total)
+	{
+		for (int men = 0; men <= total; ++men)
+		{
+			std::vector<material> group;
+			for (int redmen = 0; redmen <= men; ++redmen)
+			{
+				for (int redkings = 0; redkings <= total - men; ++redkings)
+				{
+					group.push_back({ redmen, redkings, men - redmen, total - men - redkings });
+				}
+			}
+
+			auto start = std::chrono::high_resolution_clock::now();
+			std::atomic<size_t> next = 0;
+			auto work = [&]()
+			{
+				for (size_t i = next++; i < group.size(); i = next++)
+				{
+					solve(group[i]);
+				}
+			};
+
+			std::vector<std::thread> workers;
+			for (int i = 0; i < std::min<int>(threads, (int)group.size()); ++i)
+			{
+				workers.push_back(std::thread{ work });
+			}
+
+			for (auto &worker : workers)
+			{
+				worker.join();
+			}
+
+			if (!verbose)
+				continue;
+
+			// the results of the group, the invalid placements count as draws
+			uint64_t positions = 0, wins = 0, losses = 0;
+			int longest = 0;
+			for (auto &m : group)
+			{
+				for (uint16_t entry : m_tables[table_index(m)])
+				{
+					positions += 1;
+					wins += (entry & 3) == (int)outcome::WIN;
+					losses += (entry & 3) == (int)outcome::LOSS;
+					longest = std::max(longest, entry >> 2);
+				}
+			}
+
+			std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+			std::cout << total << " pieces, " << men << " men: " << group.size() << " materials, " << positions << " positions, "
+				<< wins << " wins, " << losses << " losses, longest " << longest << " plies, " << seconds.count() << "s" << std::endl;
+		}
+	}
+}
+
+bool tablebase::tablebase::probe(const checkers::board &board, checkers::state turn, tbentry &out) const
+{
+	material m = material_of(board);
+	if (m.pieces() == 0 || m.pieces() > m_pieces)
+		return false;
+
+	const std::vector<uint16_t> &table = m_tables[table_index(m)];
+	if (table.empty())
+		return false;
+
+	uint16_t entry = table[position_index(m, board, turn)];
+	out.result = (outcome)(entry & 3);
+	out.distance = entry >> 2;
+	return true;
+}
+
+int tablebase::tablebase::pieces() const
+{
+	return m_pieces;
+}
+
+bool tablebase::tablebase::save(const std::string &path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.write("TDTB", 4);
+	int32_t pieces = m_pieces;
+	file.write((const char *)&pieces, sizeof(pieces));
+	for (auto &table : m_tables)
+	{
+		uint64_t size = table.size();
+		file.write((const char *)&size, sizeof(size));
+		file.write((const char *)table.data(), size * sizeof(uint16_t));
+	}
+
+	return (bool)file;
+}
+
+bool tablebase::tablebase::load(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	char magic[4];
+	int32_t pieces;
+	if (!file.read(magic, 4) || std::string(magic, 4) != "TDTB" || !file.read((char *)&pieces, sizeof(pieces)) || pieces < 1)
+		return false;
+
+	size_t base = pieces + 1;
+	std::vector<std::vector<uint16_t>> tables(base * base * base * base);
+	for (auto &table : tables)
+	{
+		uint64_t size;
+		if (!file.read((char *)&size, sizeof(size)))
+			return false;
+
+		table.resize(size);
+		if (!file.read((char *)table.data(), size * sizeof(uint16_t)))
+			return false;
+	}
+
+	m_pieces = pieces;
+	m_tables = std::move(tables);
+	return true;
+}
+
+void tablebase::tablebase::solve(const material &m)
+{
+	uint64_t size = material_size(m);
+	std::vector<uint16_t> &table = m_tables[table_index(m)];
+	table.assign(size, G_TABLEBASE_UNKNOWN);
+
+	// the moves within the material not known to lose yet, with the winning and drawing flags,
+	// and the slowest loss among the moves known to lose
+	std::vector<uint8_t> remaining(size, 0);
+	std::vector<uint16_t> longest(size, 0);
+
+	// the positions to resolve at each distance, odd distances win and even distances lose
+	std::vector<std::vector<uint32_t>> pending;
+	auto push = [&](int distance, uint64_t index)
+	{
+		if (pending.size() <= (size_t)distance)
+			pending.resize(distance + 1);
+		pending[distance].push_back((uint32_t)index);
+	};
+
+	// the moves leaving the material are resolved by its solved tables
+	checkers::move_list moves;
+	checkers::board board;
+	checkers::state turn;
+	for (uint64_t index = 0; index < size; ++index)
+	{
+		// the placements with overlapping pieces are never probed
+		if (!position_board(m, index, board, turn))
+		{
+			table[index] = pack_entry((int)outcome::DRAW, 0);
+			continue;
+		}
+
+		board.compute_moves(turn, moves);
+		if (moves.empty())
+		{
+			push(0, index);
+			continue;
+		}
+
+		int inside = 0;
+		int win = INT_MAX;
+		int slowest = 0;
+		bool draw = false;
+		for (auto &move : moves)
+		{
+			checkers::board child = board.perform_move(move, turn);
+			if (material_of(child) == m)
+			{
+				inside += 1;
+				continue;
+			}
+
+			tbentry entry;
+			probe(child, checkers::state_flip(turn), entry);
+			if (entry.result == outcome::LOSS)
+				win = std::min(win, entry.distance + 1);
+			else if (entry.result == outcome::WIN)
+				slowest = std::max(slowest, entry.distance + 1);
+			else
+				draw = true;
+		}
+
+		remaining[index] = (uint8_t)(inside | (draw ? G_TABLEBASE_DRAWING : 0));
+		longest[index] = (uint16_t)slowest;
+
+		if (win != INT_MAX)
+		{
+			remaining[index] |= G_TABLEBASE_WINNING;
+			push(win, index);
+		}
+		else if (inside == 0 && !draw)
+			push(slowest, index);
+	}
+
+	// resolve the positions by increasing distance, taking back the moves within the material to reach their parents,
+	// a parent of a loss wins one ply later, and a parent loses once all its moves were found to lose
+	checkers::move_list unmoves;
+	for (size_t distance = 0; distance < pending.size(); ++distance)
+	{
+		bool win = distance % 2 == 1;
+		for (size_t i = 0; i < pending[distance].size(); ++i)
+		{
+			uint64_t index = pending[distance][i];
+			if ((table[index] & 3) != G_TABLEBASE_UNKNOWN)
+				continue;
+
+			table[index] = pack_entry((int)(win ? outcome::WIN : outcome::LOSS), (int)distance);
+
+			position_board(m, index, board, turn);
+			checkers::state mover = checkers::state_flip(turn);
+			board.compute_unmoves(mover, unmoves);
+			for (auto &unmove : unmoves)
+			{
+				checkers::board parent = board.perform_move(checkers::compact_move(unmove.to, unmove.from), mover);
+				uint64_t parentindex = position_index(m, parent, mover);
+				if ((table[parentindex] & 3) != G_TABLEBASE_UNKNOWN)
+					continue;
+
+				if (!win)
+				{
+					remaining[parentindex] |= G_TABLEBASE_WINNING;
+					push((int)distance + 1, parentindex);
+					continue;
+				}
+
+				uint8_t left = remaining[parentindex];
+				remaining[parentindex] = (uint8_t)((left & ~G_TABLEBASE_COUNT) | ((left & G_TABLEBASE_COUNT) - 1));
+				longest[parentindex] = std::max<uint16_t>(longest[parentindex], (uint16_t)(distance + 1));
+
+				if ((left & G_TABLEBASE_COUNT) == 1 && (left & (G_TABLEBASE_WINNING | G_TABLEBASE_DRAWING)) == 0)
+					push(longest[parentindex], parentindex);
+			}
+		}
+	}
+
+	// the positions never resolved can avoid losing forever
+	for (auto &entry : table)
+	{
+		if ((entry & 3) == G_TABLEBASE_UNKNOWN)
+			entry = pack_entry((int)outcome::DRAW, 0);
+	}
+}
+
+size_t tablebase::tablebase::table_index(const material &m) const
+{
+	int base = m_pieces + 1;
+	return (((size_t)m.redmen * base + m.redkings) * base + m.blackmen) * base + m.blackkings;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "checkers.h"
+
+
+// The number of pieces the endgame tables are generated up to by default
+#define G_TABLEBASE_PIECES (4)
+
+namespace tablebase
+{
+	// the exact result of a position for the side to move
+	enum class outcome : uint8_t
+	{
+		DRAW = 0,
+		WIN,
+		LOSS,
+	};
+
+	struct tbentry
+	{
+		outcome result;
+		// the plies until the game ends with best play, the winner the fastest and the loser the slowest, 0 for draws
+		int distance;
+	};
+
+	// the number of men and kings of each side, every combination of them is a table of its own
+	struct material
+	{
+		int redmen;
+		int redkings;
+		int blackmen;
+		int blackkings;
+
+		int pieces() const
+		{
+			return redmen + redkings + blackmen + blackkings;
+		}
+
+		bool operator==(const material &other) const
+		{
+			return redmen == other.redmen && redkings == other.redkings && blackmen == other.blackmen && blackkings == other.blackkings;
+		}
+	};
+
+	/**
+	 * @brief Endgame tables of every position up to a number of pieces, both sides to move
+	 *
+	 * generated by retrograde analysis, a material is solved once every material its captures
+	 * and promotions reach is solved, the moves within the material are taken back with the unmove generator,
+	 * the materials with the same number of pieces and men are solved in parallel
+	*/
+	class tablebase
+	{
+	public:
+		// an empty tablebase, without any materials
+		tablebase();
+
+		// generates all materials with up to pieces pieces on threads threads, defaulting to one per core
+		void generate(int pieces = G_TABLEBASE_PIECES, int threads = 0, bool verbose = true);
+
+		// looks up the position with the turn to move, returns whether its material is in the tables
+		bool probe(const checkers::board &board, checkers::state turn, tbentry &out) const;
+
+		// the number of pieces the tables cover
+		int pieces() const;
+
+		// writes the tables to a binary file, and reads them back, returns whether it succeeded
+		bool save(const std::string &path) const;
+		bool load(const std::string &path);
+
+	private:
+		// solves the positions of the material, the materials it reaches must be solved
+		void solve(const material &m);
+
+		// the index of the table of the material
+		size_t table_index(const material &m) const;
+
+	private:
+		int m_pieces;
+
+		// the entry of each position of each material, the result in the low 2 bits and the distance above,
+		// indexed by the material, then by the placement of each kind of piece and the side to move
+		std::vector<std::vector<uint16_t>> m_tables;
+	};
+}
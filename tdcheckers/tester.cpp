@@ -3,45 +3,604 @@
 #include <vector>
 #include <unordered_set>
 #include <random>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <cmath>
 #include "explorer.h"
 
-void testing::explore_moves(checkers::board position, checkers::state turn)
+
+// a perft hash table entry, the check is the key xor the nodes so torn writes from other threads are rejected
+struct perft_entry
 {
-	std::vector<checkers::board> positions{position};
-	//std::unordered_set<checkers::board, checkers::board::hash_function> positions{position};
+	std::atomic<uint64_t> check;
+	std::atomic<uint64_t> nodes;
+};
 
-	int depth = 0;
-	while (true)
+// a lock-free table of (position, side, depth) -> leaf count, shared by all perft threads
+class perft_table
+{
+public:
+	perft_table(size_t megabytes)
 	{
-		size_t actions = 0;
-		std::vector<checkers::board> nextpositions;
-		//std::unordered_set<checkers::board, checkers::board::hash_function> nextpositions;
-		for (auto &board : positions)
-		{
-			std::vector<checkers::move> moves = position.compute_moves(turn);
-			actions += moves.size();
+		// round down to a power of two number of entries
+		size_t entries = (megabytes << 20) / sizeof(perft_entry);
+		m_mask = 0;
+		while (entries > 1 && m_mask * 2 + 1 < entries)
+			m_mask = m_mask * 2 + 1;
+
+		m_entries = std::make_unique<perft_entry[]>(m_mask + 1);
+	}
+
+	bool probe(uint64_t key, uint64_t &nodes) const
+	{
+		const perft_entry &entry = m_entries[key & m_mask];
+		nodes = entry.nodes.load(std::memory_order_relaxed);
+		return (entry.check.load(std::memory_order_relaxed) ^ nodes) == key;
+	}
+
+	void store(uint64_t key, uint64_t nodes)
+	{
+		perft_entry &entry = m_entries[key & m_mask];
+		entry.nodes.store(nodes, std::memory_order_relaxed);
+		entry.check.store(key ^ nodes, std::memory_order_relaxed);
+	}
+
+private:
+	std::unique_ptr<perft_entry[]> m_entries;
+	size_t m_mask;
+};
+
+// mixes the bits of a 64 bit integer
+static uint64_t perft_mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+// the perft table key of the position, side and depth
+static uint64_t perft_key(const checkers::board &position, checkers::state turn, int depth)
+{
+	return position.get_hash(turn) ^ perft_mix(depth);
+}
+
+// perft, making and taking back the moves on the position
+static uint64_t perft_inplace(checkers::board &position, checkers::state turn, int depth)
+{
+	checkers::move_list moves;
+	position.compute_moves(turn, moves);
+
+	// bulk counting, the leaves need not be played
+	if (depth == 1)
+		return moves.size;
+
+	uint64_t nodes = 0;
+	checkers::state next = checkers::state_flip(turn);
+	checkers::undo undo;
+	for (auto &move : moves)
+	{
+		position.make(move, undo);
+		nodes += perft_inplace(position, next, depth - 1);
+		position.unmake(undo);
+	}
+
+	return nodes;
+}
+
+// perft, caching the counts of the interior positions in the table
+static uint64_t perft_hashed(checkers::board &position, checkers::state turn, int depth, perft_table &table)
+{
+	if (depth == 0)
+		return 1;
+
+	checkers::move_list moves;
+	position.compute_moves(turn, moves);
+
+	if (depth == 1)
+		return moves.size;
+
+	uint64_t key = perft_key(position, turn, depth);
+	uint64_t cached;
+	if (table.probe(key, cached))
+		return cached;
+
+	uint64_t nodes = 0;
+
+	checkers::state next = checkers::state_flip(turn);
+	checkers::undo undo;
+	for (auto &move : moves)
+	{
+		position.make(move, undo);
+		nodes += perft_hashed(position, next, depth - 1, table);
+		position.unmake(undo);
+	}
+
+	table.store(key, nodes);
+	return nodes;
+}
+
+// collects every position reached after exactly depth moves, with repeats
+static void perft_split(const checkers::board &position, checkers::state turn, int depth, std::vector<std::pair<checkers::board, checkers::state>> &out)
+{
+	if (depth == 0)
+	{
+		out.push_back({ position, turn });
+		return;
+	}
+
+	checkers::move_list moves;
+	position.compute_moves(turn, moves);
+
+	checkers::state next = checkers::state_flip(turn);
+	for (auto &move : moves)
+	{
+		perft_split(position.perform_move(move, turn), next, depth - 1, out);
+	}
+}
+
+uint64_t testing::perft(const checkers::board &position, checkers::state turn, int depth)
+{
+	if (depth == 0)
+		return 1;
+
+	checkers::board board = position;
+	return perft_inplace(board, turn, depth);
+}
+
+uint64_t testing::perft_parallel(const checkers::board &position, checkers::state turn, int depth, int threads, int splitdepth, size_t hashmb)
+{
+	splitdepth = std::clamp(splitdepth, 0, depth);
+	threads = std::max(threads, 1);
 
-			for (auto &m : moves)
-				nextpositions.push_back(board.perform_move(m, turn));
+	// the tasks are the positions at the split depth
+	std::vector<std::pair<checkers::board, checkers::state>> tasks;
+	perft_split(position, turn, splitdepth, tasks);
+
+	perft_table table(std::max<size_t>(hashmb, 1));
+	std::atomic<size_t> next = 0;
+	std::atomic<uint64_t> total = 0;
+
+	auto work = [&]()
+	{
+		uint64_t nodes = 0;
+		for (size_t i = next++; i < tasks.size(); i = next++)
+		{
+			checkers::board board = tasks[i].first;
+			nodes += perft_hashed(board, tasks[i].second, depth - splitdepth, table);
 		}
 
-		std::cout << "Depth " << depth << ": " << actions << std::endl;
+		total += nodes;
+	};
 
-		// update boards
-		positions = nextpositions;
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i)
+	{
+		workers.push_back(std::thread{ work });
+	}
 
-		// update turn
-		if (turn == checkers::state::RED)
-			turn = checkers::state::BLACK;
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+
+	return total;
+}
+
+void testing::divide(const checkers::board &position, checkers::state turn, int depth)
+{
+	checkers::move_list moves;
+	position.compute_moves(turn, moves);
+
+	uint64_t total = 0;
+	checkers::state next = checkers::state_flip(turn);
+	for (auto &move : moves)
+	{
+		uint64_t nodes = perft(position.perform_move(move, turn), next, depth - 1);
+		total += nodes;
+
+		std::cout << move.expand().str() << ": " << nodes << std::endl;
+	}
+
+	std::cout << "\nMoves: " << moves.size << std::endl;
+	std::cout << "Nodes: " << total << std::endl;
+}
+
+// the limits of a search to exactly depth, however many nodes it takes
+static explorer::search_limits fixed_depth(int depth)
+{
+	explorer::search_limits limits;
+	limits.depth = depth;
+	limits.nodes = 0;
+	return limits;
+}
+
+// a position of the benchmarks, with its perft depth
+struct benchmark
+{
+	const char *position;
+	checkers::state turn;
+	int depth;
+};
+
+// nullptr is the starting position
+static const benchmark benchmarks[] = {
+	{ nullptr, checkers::state::RED, 9 },
+	{
+		". . . . . . . ."
+		"x . x . x . . ."
+		". x . x . x . x"
+		"x . x . x . o ."
+		". . . o . . . ."
+		"o . o . o . o ."
+		". o . o . . . o"
+		". . o . . . . .",
+		checkers::state::BLACK, 9
+	},
+	{
+		". . . O . . . x"
+		"x . x . . . . ."
+		". x . x . x . x"
+		"o . x . . . x ."
+		". o . . . o . o"
+		"o . . . O . o ."
+		". o . . . . . ."
+		". . . . o . o .",
+		checkers::state::RED, 9
+	},
+	{
+		". . . . . . . ."
+		". . O . . . . ."
+		". X . O . . . ."
+		". . . . . . . ."
+		". . . O . . . ."
+		". . . . O . . ."
+		". . . O . . . ."
+		". . . . O . . .",
+		checkers::state::RED, 9
+	},
+};
+
+void testing::perft_benchmark(int threads, size_t hashmb)
+{
+	uint64_t totalnodes = 0;
+	double totaltime = 0.0;
+	for (auto &bench : benchmarks)
+	{
+		checkers::board board;
+		if (bench.position != nullptr)
+			board = checkers::board(std::string(bench.position));
+
+		auto start = std::chrono::steady_clock::now();
+		uint64_t nodes;
+		if (threads > 1 || hashmb > 0)
+			nodes = perft_parallel(board, bench.turn, bench.depth, threads, 3, hashmb);
 		else
-			turn = checkers::state::RED;
+			nodes = perft(board, bench.turn, bench.depth);
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		totalnodes += nodes;
+		totaltime += elapsed;
+
+		std::cout << checkers::state_repr(bench.turn) << " depth " << bench.depth
+			<< ": " << nodes << " nodes, " << elapsed << "s, "
+			<< (uint64_t)(nodes / std::max(elapsed, 1e-9)) << " nodes/s" << std::endl;
+	}
+
+	std::cout << "Total: " << totalnodes << " nodes, " << totaltime << "s, "
+		<< (uint64_t)(totalnodes / std::max(totaltime, 1e-9)) << " nodes/s" << std::endl;
+}
+
+void testing::search_benchmark(int depth)
+{
+	const explorer::root_search roots[] = { explorer::root_search::ALPHABETA, explorer::root_search::MTDF };
+	const char *names[] = { "alpha-beta", "mtd(f)" };
+
+	size_t totalnodes[2] = { 0, 0 };
+	double totaltime[2] = { 0.0, 0.0 };
+	for (auto &bench : benchmarks)
+	{
+		checkers::board board;
+		if (bench.position != nullptr)
+			board = checkers::board(std::string(bench.position));
+
+		for (int i = 0; i < 2; ++i)
+		{
+			// a fresh single threaded optimizer, so neither search reuses the table of the other
+			explorer::optimizer optimizer{board, bench.turn, 1};
+			optimizer.set_root_search(roots[i]);
+			optimizer.set_limits(fixed_depth(depth));
+
+			auto start = std::chrono::steady_clock::now();
+			optimizer.compute_score(bench.turn, false);
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			totalnodes[i] += optimizer.get_nodes();
+			totaltime[i] += elapsed;
+
+			std::cout << checkers::state_repr(bench.turn) << " " << names[i]
+				<< " depth " << optimizer.get_depth()
+				<< ": " << optimizer.get_nodes() << " nodes, " << elapsed << "s, score "
+				<< optimizer.get_score() << ", best " << optimizer.get_move().value().str() << std::endl;
+		}
+	}
+
+	for (int i = 0; i < 2; ++i)
+	{
+		std::cout << "Total " << names[i] << ": " << totalnodes[i] << " nodes, " << totaltime[i] << "s" << std::endl;
+	}
+}
+
+void testing::pruning_benchmark(int depth)
+{
+	struct configuration
+	{
+		const char *name;
+		explorer::search_options options;
+	};
+
+	// the options with only the given techniques, extensions and iid are on unless turned off
+	auto only = [](bool reductions, bool futility, bool razoring, bool probcut, bool extensions = true, bool iid = true)
+	{
+		explorer::search_options options;
+		options.reductions = reductions;
+		options.futility = futility;
+		options.razoring = razoring;
+		options.probcut = probcut;
+		options.iid = iid;
+		if (!extensions)
+			std::fill(std::begin(options.extensions), std::end(options.extensions), 0);
+		return options;
+	};
+
+	const configuration configurations[] = {
+		{ "full width", only(false, false, false, false) },
+		{ "reductions", only(true, false, false, false) },
+		{ "futility", only(false, true, false, false) },
+		{ "razoring", only(false, false, true, false) },
+		{ "probcut", only(false, false, false, true) },
+		{ "all", only(true, true, true, true) },
+		{ "all, no extensions", only(true, true, true, true, false) },
+		{ "all, no iid", only(true, true, true, true, true, false) },
+	};
+	constexpr int count = sizeof(configurations) / sizeof(configurations[0]);
+
+	size_t totalnodes[count] = {};
+	int agreements[count] = {};
+	for (auto &bench : benchmarks)
+	{
+		checkers::board board;
+		if (bench.position != nullptr)
+			board = checkers::board(std::string(bench.position));
+
+		// the best move of the full width search, which the selective searches should agree with
+		std::string reference;
+		for (int i = 0; i < count; ++i)
+		{
+			explorer::optimizer optimizer{board, bench.turn, 1};
+			optimizer.set_limits(fixed_depth(depth));
+			optimizer.set_options(configurations[i].options);
+			optimizer.compute_score(bench.turn, false);
+
+			const explorer::search_stats &stats = optimizer.get_stats();
+			std::string best = optimizer.get_move().value().str();
+			if (i == 0)
+				reference = best;
+
+			totalnodes[i] += optimizer.get_nodes();
+			agreements[i] += best == reference;
+
+			std::cout << checkers::state_repr(bench.turn) << " " << configurations[i].name
+				<< " depth " << optimizer.get_depth()
+				<< ": " << optimizer.get_nodes() << " nodes, score " << optimizer.get_score()
+				<< ", best " << best
+				<< " (reductions " << stats.reductions << ", researches " << stats.researches
+				<< ", futility " << stats.futility << ", razoring " << stats.razoring << ", probcut " << stats.probcut
+				<< ", iid " << stats.iidmoves << "/" << stats.iid
+				<< ", extensions " << stats.extensions[(int)explorer::extension::CAPTURES]
+				<< "/" << stats.extensions[(int)explorer::extension::PROMOTION]
+				<< "/" << stats.extensions[(int)explorer::extension::SINGLE_REPLY]
+				<< "/" << stats.extensions[(int)explorer::extension::THREAT]
+				<< " for " << stats.extended << " plies)" << std::endl;
+		}
+	}
+
+	int positions = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	for (int i = 0; i < count; ++i)
+	{
+		std::cout << "Total " << configurations[i].name << ": " << totalnodes[i] << " nodes, "
+			<< agreements[i] << "/" << positions << " best moves agree" << std::endl;
+	}
+}
+
+std::vector<std::pair<checkers::board, checkers::state>> testing::load_positions(const std::string &path)
+{
+	std::vector<std::pair<checkers::board, checkers::state>> positions;
+
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::string stripped;
+		for (auto c : line)
+		{
+			if (!isspace(c))
+				stripped += c;
+		}
+
+		// skip blank lines and comments
+		if (stripped.empty() || stripped[0] == '#')
+			continue;
+
+		if (stripped.size() != G_CHECKERS_SIZE + 1)
+		{
+			std::cout << "skipping malformed position: " << line << std::endl;
+			continue;
+		}
+
+		checkers::state turn = tolower(stripped.back()) == 'b' ? checkers::state::BLACK : checkers::state::RED;
+		positions.push_back({ checkers::board(stripped.substr(0, G_CHECKERS_SIZE)), turn });
+	}
+
+	return positions;
+}
+
+// the line of a position as load_positions reads it
+static std::string position_text(const checkers::board &board, checkers::state turn)
+{
+	std::string text;
+	for (int i = 0; i < G_CHECKERS_SIZE; ++i)
+	{
+		char piece = G_BLANKPIECE;
+		if (board.get_player(checkers::state::RED) & (1ull << i))
+			piece = G_REDPIECE;
+		else if (board.get_player(checkers::state::BLACK) & (1ull << i))
+			piece = G_BLACKPIECE;
+		if ((board.get_kings(checkers::state::RED) | board.get_kings(checkers::state::BLACK)) & (1ull << i))
+			piece = toupper(piece);
+		text += piece;
+	}
+
+	return text + " " + (turn == checkers::state::RED ? 'r' : 'b');
+}
+
+void testing::generate_corpus(const std::string &path, int count, int seed)
+{
+	std::mt19937 rng(seed);
+	std::ofstream file(path);
+
+	int written = 0;
+	while (written < count)
+	{
+		checkers::board board;
+		checkers::state turn = checkers::state::RED;
+
+		// play a random game, keeping a position every few plies
+		int plies = std::uniform_int_distribution<>(4, 11)(rng);
+		for (int ply = 0; written < count; ++ply)
+		{
+			checkers::move_list moves;
+			board.compute_moves(turn, moves);
+			if (moves.empty())
+				break;
+
+			if (ply == plies)
+			{
+				file << position_text(board, turn) << "\n";
+				written += 1;
+				plies += std::uniform_int_distribution<>(4, 11)(rng);
+			}
 
-		depth += 1;
+			int choice = std::uniform_int_distribution<>(0, moves.size - 1)(rng);
+			board = board.perform_move(moves[choice], turn);
+			turn = checkers::state_flip(turn);
+		}
 	}
+}
 
+explorer::probcut_model testing::probcut_fit(const std::string &corpus, const std::string &log, int shallow, int deep, float errorrate)
+{
+	auto positions = load_positions(corpus);
+	std::ofstream logfile(log);
+	logfile << "shallow,deep\n";
 
+	// the searches must not be cut by the model being fitted
+	explorer::search_options options;
+	options.probcut = false;
 
+	// score the position at a fixed depth, from the perspective of the side moving
+	auto score = [&](const checkers::board &board, checkers::state turn, int depth)
+	{
+		explorer::optimizer optimizer{board, turn, 1};
+		optimizer.set_options(options);
+		optimizer.set_limits(fixed_depth(depth));
+		optimizer.compute_score(turn, false);
+		return std::make_pair(optimizer.get_score(), optimizer.get_depth());
+	};
+
+	std::vector<std::pair<float, float>> pairs;
+	for (auto &[board, turn] : positions)
+	{
+		checkers::move_list moves;
+		board.compute_moves(turn, moves);
+		if (moves.empty())
+			continue;
+
+		auto [shallowscore, shallowdepth] = score(board, turn, shallow);
+		auto [deepscore, deepdepth] = score(board, turn, deep);
+
+		// decided positions and searches stopped early say nothing about the model
+		if (std::abs(shallowscore) > 100.0f || std::abs(deepscore) > 100.0f || shallowdepth != shallow || deepdepth != deep)
+			continue;
 
+		pairs.push_back({ shallowscore, deepscore });
+		logfile << shallowscore << "," << deepscore << "\n";
+	}
+
+	explorer::probcut_model model = explorer::search_options().probcut_params;
+	model.shallow = shallow;
+	model.deep = deep;
+	if (pairs.size() < 2)
+	{
+		std::cout << "not enough pairs to fit, " << pairs.size() << " of " << positions.size() << " positions usable" << std::endl;
+		return model;
+	}
+
+	// least squares fit of deep = slope * shallow + intercept
+	double n = (double)pairs.size();
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	for (auto &[x, y] : pairs)
+	{
+		sx += x;
+		sy += y;
+		sxx += (double)x * x;
+		sxy += (double)x * y;
+	}
+
+	double variance = sxx - sx * sx / n;
+	double slope = variance > 1e-12 ? (sxy - sx * sy / n) / variance : 1.0;
+	double intercept = (sy - slope * sx) / n;
+
+	// a high cut fails when the deep score falls below the prediction, a low cut when it rises above it
+	std::vector<double> below, above;
+	double squares = 0.0;
+	for (auto &[x, y] : pairs)
+	{
+		double residual = y - (slope * x + intercept);
+		below.push_back(-residual);
+		above.push_back(residual);
+		squares += residual * residual;
+	}
+	double sigma = std::sqrt(squares / std::max(n - 2.0, 1.0));
+
+	// the threshold of a side is the number of sigmas that all but the error rate of its residuals fall within
+	auto threshold = [&](std::vector<double> &residuals)
+	{
+		std::sort(residuals.begin(), residuals.end());
+		size_t rank = (size_t)std::ceil((1.0 - errorrate) * residuals.size());
+		size_t index = std::clamp<size_t>(rank, 1, residuals.size()) - 1;
+		return sigma > 1e-9 ? std::max(residuals[index], 0.0) / sigma : 0.0;
+	};
+
+	model.slope = (float)slope;
+	model.intercept = (float)intercept;
+	model.sigma = (float)sigma;
+	model.highthreshold = (float)threshold(below);
+	model.lowthreshold = (float)threshold(above);
+
+	std::cout << pairs.size() << " pairs of " << positions.size() << " positions" << std::endl;
+	std::cout << "deep = " << model.slope << " * shallow + " << model.intercept << ", sigma " << model.sigma
+		<< ", thresholds " << model.highthreshold << " high, " << model.lowthreshold << " low" << std::endl;
+
+	return model;
 }
 
 void testing::random_play()
@@ -271,3 +830,89 @@ void testing::analyze(checkers::board position, checkers::state turn)
 	std::cout << "Score is " << optimizer.get_score() << std::endl;
 	std::cout << "Best is " << optimizer.get_move().value().str() << std::endl;
 }
+
+void testing::analyze_batch(const std::string &positions, const std::string &results, int depth, size_t nodes, int threads, size_t hashmb)
+{
+	auto tasks = load_positions(positions);
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	explorer::search_limits limits = fixed_depth(depth);
+	limits.nodes = nodes;
+
+	// one single threaded search per worker, on a transposition table shared by all of them
+	auto table = std::make_shared<explorer::transpositiontable>(std::max<size_t>(hashmb, 1));
+
+	std::ofstream file(results);
+	file << "position\tscore\tbest\tdepth\tnodes\tmilliseconds\tpv\n";
+
+	// the results are written in the order of the positions, as soon as all before them are done
+	std::vector<std::optional<std::string>> lines(tasks.size());
+	size_t written = 0;
+	std::mutex lock;
+
+	std::atomic<size_t> next = 0;
+	std::atomic<uint64_t> total = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto work = [&]()
+	{
+		explorer::optimizer optimizer{ checkers::board{}, checkers::state::RED, table, 1 };
+		optimizer.set_limits(limits);
+
+		for (size_t i = next++; i < tasks.size(); i = next++)
+		{
+			auto &[board, turn] = tasks[i];
+
+			auto begin = std::chrono::high_resolution_clock::now();
+			optimizer.update_board(board);
+			optimizer.compute_score(turn, false);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - begin;
+			total += optimizer.get_nodes();
+
+			// the optimizer scores from the perspective of red, the results from the side moving
+			float score = turn == checkers::state::RED ? optimizer.get_score() : -optimizer.get_score();
+			const auto &best = optimizer.get_move();
+
+			std::string line = position_text(board, turn);
+			line += "\t" + std::to_string(score);
+			line += "\t" + (best.has_value() ? best.value().str() : std::string("none"));
+			line += "\t" + std::to_string(optimizer.get_depth());
+			line += "\t" + std::to_string(optimizer.get_nodes());
+			line += "\t" + std::to_string(elapsed.count()) + "\t";
+			for (auto &move : optimizer.get_lines())
+			{
+				line += (&move == &optimizer.get_lines().front() ? "" : " ") + move.str();
+			}
+
+			std::lock_guard<std::mutex> guard(lock);
+			lines[i] = std::move(line);
+			while (written < lines.size() && lines[written].has_value())
+			{
+				file << lines[written].value() << "\n";
+				lines[written].reset();
+				written += 1;
+
+				if (written % 1000 == 0)
+					std::cout << "analyzed " << written << " of " << tasks.size() << std::endl;
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i)
+	{
+		workers.push_back(std::thread{ work });
+	}
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+
+	std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Analyzed " << tasks.size() << " positions on " << threads << " threads: "
+		<< total << " nodes, " << seconds.count() << "s, "
+		<< (uint64_t)(total / std::max(seconds.count(), 1e-9)) << " nodes/s, "
+		<< tasks.size() / std::max(seconds.count(), 1e-9) << " positions/s" << std::endl;
+}
@@ -1,14 +1,45 @@
 #pragma once
 
 #include "checkers.h"
+#include "explorer.h"
 
 
 namespace testing
 {
 
-	// continuously explores the number of moves from the position,
-	// follows a BFS approach
-	void explore_moves(checkers::board position, checkers::state turn);
+	// Counts the number of leaf positions reachable in exactly depth moves, depth first
+	uint64_t perft(const checkers::board &position, checkers::state turn, int depth);
+
+	// Counts the same leaves as perft, splitting the positions at splitdepth across threads,
+	// with the counts of transpositions shared through a hash table of hashmb megabytes
+	uint64_t perft_parallel(const checkers::board &position, checkers::state turn, int depth, int threads, int splitdepth = 3, size_t hashmb = 256);
+
+	// Prints the perft count below each root move, as well as the total
+	void divide(const checkers::board &position, checkers::state turn, int depth);
+
+	// Runs perft over a fixed list of positions, reporting the nodes, time and nodes per second
+	// uses perft_parallel when given more than one thread or a hash table
+	void perft_benchmark(int threads = 1, size_t hashmb = 0);
+
+	// Searches the perft benchmark positions to depth with alpha-beta and with mtd(f) at the root,
+	// reporting the nodes and time of each
+	void search_benchmark(int depth = 10);
+
+	// Searches the perft benchmark positions to depth with each selective search technique alone, none, all, and all without extensions or iid,
+	// reporting the nodes, counters and whether the best move agrees with the full width search
+	void pruning_benchmark(int depth = 10);
+
+	// Reads the positions of a file, one per line as the 64 squares of the board followed by r or b for the side to move,
+	// the squares as in the board string constructor, blank lines and lines starting with # are skipped
+	std::vector<std::pair<checkers::board, checkers::state>> load_positions(const std::string &path);
+
+	// Writes count positions from random games to a file readable by load_positions
+	void generate_corpus(const std::string &path, int count, int seed = 0);
+
+	// Fits the probcut model on the positions of the corpus file, searching each to the shallow and deep depths,
+	// the (shallow, deep) score pairs are logged to the log file as csv,
+	// the threshold of each side lets through at most the error rate of the pairs on that side
+	explorer::probcut_model probcut_fit(const std::string &corpus, const std::string &log, int shallow = 2, int deep = 6, float errorrate = 0.025f);
 
 	// Randomly play between two sides
 	void random_play();
@@ -25,6 +56,12 @@ namespace testing
 	// Analyze the board position given the turn
 	void analyze(checkers::board position, checkers::state turn);
 
+	// Analyzes the positions of a file readable by load_positions to depth, or a node budget per position when not zero,
+	// one single threaded search per thread on a shared transposition table of hashmb megabytes, defaulting to one per core,
+	// the results file has a tab separated line per position in their order, with the score from the side moving,
+	// the best move, depth, nodes, milliseconds and the principal variation
+	void analyze_batch(const std::string &positions, const std::string &results, int depth = 10, size_t nodes = 0, int threads = 0, size_t hashmb = 256);
+
 	// Matches
 };
 
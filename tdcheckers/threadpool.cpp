@@ -0,0 +1,107 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+
+explorer::threadpool::threadpool(int threads)
+	: m_epoch(0), m_running(0), m_exit(false)
+{
+	resize(threads);
+}
+
+explorer::threadpool::~threadpool()
+{
+	wait();
+	join();
+}
+
+void explorer::threadpool::resize(int threads)
+{
+	wait();
+
+	// the workers are kept when their number does not change
+	threads = std::max(threads, 1);
+	if (threads == size())
+		return;
+
+	join();
+
+	m_exit = false;
+	for (int i = 0; i < threads; ++i)
+	{
+		m_threads.push_back(std::thread{ &threadpool::work, this, i, m_epoch });
+	}
+}
+
+int explorer::threadpool::size() const
+{
+	return (int)m_threads.size();
+}
+
+void explorer::threadpool::start(std::function<void(int)> job)
+{
+	wait();
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_job = std::move(job);
+	m_running = (int)m_threads.size();
+	m_epoch += 1;
+	m_wake.notify_all();
+}
+
+void explorer::threadpool::wait()
+{
+	std::unique_lock<std::mutex> guard(m_lock);
+	m_done.wait(guard, [&]() { return m_running == 0; });
+}
+
+bool explorer::threadpool::busy() const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_running > 0;
+}
+
+void explorer::threadpool::run(std::function<void(int)> job)
+{
+	start(std::move(job));
+	wait();
+}
+
+void explorer::threadpool::work(int index, uint64_t epoch)
+{
+	std::unique_lock<std::mutex> guard(m_lock);
+	while (true)
+	{
+		// sleep until a new job is started
+		m_wake.wait(guard, [&]() { return m_exit || m_epoch != epoch; });
+		if (m_exit)
+			return;
+
+		epoch = m_epoch;
+		auto &job = m_job;
+
+		guard.unlock();
+		job(index);
+		guard.lock();
+
+		m_running -= 1;
+		if (m_running == 0)
+			m_done.notify_all();
+	}
+}
+
+void explorer::threadpool::join()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_exit = true;
+		m_wake.notify_all();
+	}
+
+	for (auto &thread : m_threads)
+	{
+		thread.join();
+	}
+
+	m_threads.clear();
+}
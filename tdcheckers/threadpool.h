@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+namespace explorer
+{
+
+// A persistent pool of worker threads, each job is run once on every worker
+// idle workers sleep on a condition variable until the next job is started
+class threadpool
+{
+public:
+	// creates the pool with the given number of workers
+	threadpool(int threads);
+
+	~threadpool();
+
+	// recreates the pool with the given number of workers, waits for the current job first,
+	// the same number of workers keeps the running ones
+	void resize(int threads);
+
+	// returns the number of workers
+	int size() const;
+
+	// runs the job on every worker with the worker index, returns immediately
+	void start(std::function<void(int)> job);
+
+	// blocks until the last started job finished on every worker
+	void wait();
+
+	// returns whether a job is still running on any worker
+	bool busy() const;
+
+	// runs the job on every worker and waits for it
+	void run(std::function<void(int)> job);
+
+private:
+	// the loop of a worker thread
+	void work(int index, uint64_t epoch);
+
+	// stops and joins all workers
+	void join();
+
+private:
+	std::vector<std::thread> m_threads;
+
+	mutable std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	// the current job, and the number of times a job was started
+	std::function<void(int)> m_job;
+	uint64_t m_epoch;
+
+	// the number of workers still running the current job
+	int m_running;
+
+	bool m_exit;
+};
+
+}
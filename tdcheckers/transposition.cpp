@@ -0,0 +1,140 @@
+#include "transposition.h"
+
+#include <bit>
+#include <algorithm>
+
+
+// packs the entry into a single word
+//   [0, 32) value, [32, 40) depth, [40, 42) bound, [42, 56) generation, [56, 64) move + 1
+static uint64_t pack(const explorer::ttable &data)
+{
+	uint64_t word = std::bit_cast<uint32_t>(data.value);
+	word |= (uint64_t)(uint8_t)data.depth << 32;
+	word |= (uint64_t)data.type << 40;
+	word |= (uint64_t)(data.generation & (G_TT_GENERATIONS - 1)) << 42;
+	word |= (uint64_t)(uint8_t)(data.move + 1) << 56;
+	return word;
+}
+
+// unpacks the entry from a single word
+static explorer::ttable unpack(uint64_t word)
+{
+	explorer::ttable data;
+	data.value = std::bit_cast<float>((uint32_t)word);
+	data.depth = (word >> 32) & 0xff;
+	data.type = (explorer::bound)((word >> 40) & 0x3);
+	data.generation = (word >> 42) & (G_TT_GENERATIONS - 1);
+	data.move = (int)((word >> 56) & 0xff) - 1;
+	return data;
+}
+
+explorer::transpositiontable::transpositiontable(size_t megabytes)
+	: m_mask(0), m_generation(0)
+{
+	resize(megabytes);
+}
+
+void explorer::transpositiontable::resize(size_t megabytes)
+{
+	// round down to a power of two number of buckets
+	size_t buckets = (megabytes << 20) / sizeof(bucket);
+	size_t count = 1;
+	while (count * 2 <= buckets)
+		count *= 2;
+
+	m_buckets = std::make_unique<bucket[]>(count);
+	m_mask = count - 1;
+}
+
+void explorer::transpositiontable::clear()
+{
+	for (size_t i = 0; i <= m_mask; ++i)
+	{
+		for (auto &entry : m_buckets[i].entries)
+		{
+			entry.check.store(0, std::memory_order_relaxed);
+			entry.data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+bool explorer::transpositiontable::probe(uint64_t key, ttable &out) const
+{
+	const bucket &b = m_buckets[key & m_mask];
+	for (auto &entry : b.entries)
+	{
+		uint64_t data = entry.data.load(std::memory_order_relaxed);
+		uint64_t check = entry.check.load(std::memory_order_relaxed);
+		if ((check ^ data) != key || data == 0)
+			continue;
+
+		out = unpack(data);
+		return true;
+	}
+
+	return false;
+}
+
+void explorer::transpositiontable::store(uint64_t key, const ttable &data)
+{
+	bucket &b = m_buckets[key & m_mask];
+	int generation = m_generation.load(std::memory_order_relaxed) & (G_TT_GENERATIONS - 1);
+
+	// reuse the slot of the same key, otherwise replace the least valuable entry,
+	// where each search generation of age is worth G_TT_AGEWEIGHT plies of depth,
+	// an entry G_TT_STALEAGE generations old is worth less than any entry of the current search
+	entry *replace = &b.entries[0];
+	int lowest = 1 << 30;
+	ttable stored = data;
+	for (auto &entry : b.entries)
+	{
+		uint64_t word = entry.data.load(std::memory_order_relaxed);
+		uint64_t check = entry.check.load(std::memory_order_relaxed);
+		if (word == 0)
+		{
+			replace = &entry;
+			break;
+		}
+
+		if ((check ^ word) == key)
+		{
+			// a shallower bound of this search keeps the deeper entry, only refreshing its move
+			ttable old = unpack(word);
+			if (data.depth < old.depth && data.type != bound::EXACT && old.generation == generation)
+			{
+				if (data.move < 0 || data.move == old.move)
+					return;
+
+				stored = old;
+				stored.move = data.move;
+			}
+
+			replace = &entry;
+			break;
+		}
+
+		ttable old = unpack(word);
+		int age = std::min((generation - old.generation) & (G_TT_GENERATIONS - 1), G_TT_STALEAGE);
+		int worth = old.depth - G_TT_AGEWEIGHT * age;
+		if (worth < lowest)
+		{
+			lowest = worth;
+			replace = &entry;
+		}
+	}
+
+	stored.generation = generation;
+	uint64_t word = pack(stored);
+	replace->data.store(word, std::memory_order_relaxed);
+	replace->check.store(key ^ word, std::memory_order_relaxed);
+}
+
+void explorer::transpositiontable::new_search()
+{
+	m_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t explorer::transpositiontable::size() const
+{
+	return (m_mask + 1) * G_TT_BUCKET;
+}
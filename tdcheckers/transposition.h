@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+
+// The default size of the transposition table in megabytes
+#define G_TT_DEFAULT_MB (32)
+
+// The number of entries sharing a cache line
+#define G_TT_BUCKET (4)
+
+// The depth in plies that one search generation of age is worth when replacing entries
+#define G_TT_AGEWEIGHT (4)
+
+// The search generations counted before they wrap around, and the age at which an entry is stale at any depth,
+// an entry must outlive a whole wrap in a bucket that keeps replacing it first to look fresh again
+#define G_TT_GENERATIONS (1 << 14)
+#define G_TT_STALEAGE (256 / G_TT_AGEWEIGHT)
+
+
+namespace explorer
+{
+
+// the kind of bound a transposition value is
+enum class bound : uint8_t
+{
+	NONE = 0,
+	// the value is exact
+	EXACT,
+	// the value is a lower bound (failed high)
+	LOWER,
+	// the value is an upper bound (failed low)
+	UPPER,
+};
+
+struct ttable
+{
+	// the value of the position, from the perspective of the turn moving
+	float value;
+	// depth of search done
+	int depth;
+	// what the value bounds
+	bound type;
+	// the search generation the entry was stored in, set by the table
+	int generation;
+	// the index of the best move in the moves computed for the position, -1 if unknown
+	int move;
+};
+
+// A fixed size, lock-free transposition table shared by all search threads
+// entries are stored as the key xor the packed data, so torn writes from other threads are never returned
+class transpositiontable
+{
+public:
+	// allocates a table of (at most) megabytes, rounded down to a power of two buckets
+	transpositiontable(size_t megabytes = G_TT_DEFAULT_MB);
+
+	// reallocates the table, losing all entries
+	void resize(size_t megabytes);
+
+	// removes all entries
+	void clear();
+
+	// looks up the key, returns whether the entry was found
+	bool probe(uint64_t key, ttable &out) const;
+
+	// stores the entry of the key, replacing the least valuable entry of the bucket,
+	// entries from older searches and shallower depths are replaced first,
+	// an entry of the key from this search is only replaced by one at least as deep, or exact
+	void store(uint64_t key, const ttable &data);
+
+	// starts a new search generation, ageing all existing entries without touching them,
+	// safe while other searches use the table
+	void new_search();
+
+	// returns the number of entries
+	size_t size() const;
+
+private:
+	struct entry
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+
+	struct alignas(64) bucket
+	{
+		entry entries[G_TT_BUCKET];
+	};
+
+	std::unique_ptr<bucket[]> m_buckets;
+	size_t m_mask;
+	// shared by the optimizers of a table, which start their searches independently, wraps at G_TT_GENERATIONS
+	std::atomic<uint32_t> m_generation;
+};
+
+}
@@ -1 +1,374 @@
 #include "uci.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#include "transposition.h"
+
+
+std::vector<std::string> uci::tokenize(const std::string &command)
+{
+	std::vector<std::string> tokens;
+	std::istringstream stream(command);
+	std::string token;
+	while (stream >> token)
+	{
+		tokens.push_back(token);
+	}
+
+	return tokens;
+}
+
+static std::string lowercase(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return text;
+}
+
+std::string uci::score_text(float score)
+{
+	if (std::abs(score) > 100.0f)
+		return score > 0 ? "win" : "loss";
+
+	return "cp " + std::to_string((int)std::round(score * 100.0f));
+}
+
+std::optional<std::string> uci::read_position(const std::vector<std::string> &tokens, size_t &i, setup &out)
+{
+	// the starting position has red moving first
+	out = setup{};
+	if (i < tokens.size() && tokens[i] == "startpos")
+	{
+		i += 1;
+	}
+	else if (i + 2 < tokens.size() && tokens[i] == "board" && tokens[i + 1].size() == G_CHECKERS_SIZE)
+	{
+		out.board = checkers::board(tokens[i + 1]);
+		out.turn = lowercase(tokens[i + 2]) == "b" ? checkers::state::BLACK : checkers::state::RED;
+		i += 3;
+	}
+	else
+		return "invalid position";
+
+	if (i == tokens.size() || tokens[i] != "moves")
+		return std::nullopt;
+
+	// the moves are matched against the legal moves by their shorthand, which always has a comma
+	for (++i; i < tokens.size() && tokens[i].find(',') != std::string::npos; ++i)
+	{
+		std::vector<checkers::move> moves = out.board.compute_moves(out.turn);
+		auto move = std::find_if(moves.begin(), moves.end(), [&](const checkers::move &m) { return m.str() == tokens[i]; });
+		if (move == moves.end())
+			return "illegal move " + tokens[i];
+
+		out.previous = out.board;
+		out.last = *move;
+		out.board = out.board.perform_move(*move, out.turn);
+		out.turn = checkers::state_flip(out.turn);
+	}
+
+	return std::nullopt;
+}
+
+uci::uci::uci()
+	: m_optimizer(), m_position(),
+	m_searching(checkers::state::RED), m_hash(G_TT_DEFAULT_MB), m_lock(), m_hold(false), m_infinite(false), m_held(),
+	m_running(true)
+{
+	m_optimizer = std::make_unique<explorer::optimizer>(m_position.board, checkers::state::RED);
+	m_optimizer->on_progress([this](const explorer::search_info &info) { progress(info); });
+	m_optimizer->on_finished([this](const explorer::search_info &info) { finished(info); });
+}
+
+uci::uci::~uci()
+{
+	// the callbacks of the search must run while the members are alive
+	m_optimizer->stop();
+}
+
+void uci::uci::handle(const std::string &command)
+{
+	std::vector<std::string> tokens = tokenize(command);
+	if (tokens.empty())
+		return;
+
+	std::string name = tokens[0];
+	tokens.erase(tokens.begin());
+
+	try
+	{
+		if (name == "uci")
+			identify();
+		else if (name == "isready")
+			send("readyok");
+		else if (name == "setoption")
+			setoption(tokens);
+		else if (name == "ucinewgame")
+		{
+			stop();
+			m_optimizer->set_hash_size(m_hash);
+		}
+		else if (name == "position")
+			position(tokens);
+		else if (name == "go")
+			go(tokens);
+		else if (name == "ponderhit")
+			ponderhit();
+		else if (name == "stop")
+			stop();
+		else if (name == "quit")
+		{
+			stop();
+			m_running = false;
+		}
+		else
+			send("info string unknown command " + name);
+	}
+	catch (const std::exception &)
+	{
+		send("info string invalid command " + command);
+	}
+}
+
+bool uci::uci::running() const
+{
+	return m_running;
+}
+
+void uci::uci::send(const std::string &line)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	std::cout << line << std::endl;
+}
+
+void uci::uci::identify()
+{
+	send("id name tdcheckers");
+	send("id author Troppydash");
+	send("option name Hash type spin default " + std::to_string(G_TT_DEFAULT_MB) + " min 1 max 65536");
+	send("option name Threads type spin default " + std::to_string(std::max(1u, std::thread::hardware_concurrency())) + " min 1 max 256");
+	send("uciok");
+}
+
+void uci::uci::setoption(const std::vector<std::string> &tokens)
+{
+	// setoption name <name> value <value>
+	auto name = std::find(tokens.begin(), tokens.end(), "name");
+	auto value = std::find(tokens.begin(), tokens.end(), "value");
+	if (name == tokens.end() || name + 1 == tokens.end() || value == tokens.end() || value + 1 == tokens.end())
+	{
+		send("info string setoption needs a name and a value");
+		return;
+	}
+
+	std::string option = lowercase(*(name + 1));
+	if (option == "hash")
+	{
+		m_hash = std::max(1ll, std::stoll(*(value + 1)));
+		stop();
+		m_optimizer->set_hash_size(m_hash);
+	}
+	else if (option == "threads")
+	{
+		stop();
+		m_optimizer->set_threads(std::max(1, std::stoi(*(value + 1))));
+	}
+	else
+		send("info string unknown option " + *(name + 1));
+}
+
+void uci::uci::position(const std::vector<std::string> &tokens)
+{
+	// an invalid position leaves the last one set up
+	size_t i = 0;
+	setup position;
+	std::optional<std::string> error = read_position(tokens, i, position);
+	if (error.has_value())
+	{
+		send("info string " + error.value());
+		return;
+	}
+
+	m_position = position;
+}
+
+void uci::uci::go(const std::vector<std::string> &tokens)
+{
+	// a running search is finished first, reporting its bestmove
+	stop();
+
+	// the limits given replace the defaults, which apply to a go without any
+	explorer::search_limits limits;
+	limits.nodes = 0;
+	bool given = false;
+	bool infinite = false;
+	bool ponder = false;
+
+	bool red = m_position.turn == checkers::state::RED;
+	for (size_t i = 0; i < tokens.size(); ++i)
+	{
+		const std::string &token = tokens[i];
+		if (token == "infinite")
+		{
+			infinite = true;
+			continue;
+		}
+
+		if (token == "ponder")
+		{
+			ponder = true;
+			continue;
+		}
+
+		// unknown tokens are skipped
+		static const std::vector<std::string> numeric = { "depth", "nodes", "movetime", "rtime", "btime", "rinc", "binc", "movestogo" };
+		if (std::find(numeric.begin(), numeric.end(), token) == numeric.end() || i + 1 == tokens.size())
+			continue;
+
+		long long value = std::stoll(tokens[++i]);
+		given = true;
+
+		// only the clock of the side moving counts
+		if (token == "depth")
+			limits.depth = (int)value;
+		else if (token == "nodes")
+			limits.nodes = value;
+		else if (token == "movetime")
+			limits.movetime = value;
+		else if (token == (red ? "rtime" : "btime"))
+			limits.time = value;
+		else if (token == (red ? "rinc" : "binc"))
+			limits.increment = value;
+		else if (token == "movestogo")
+			limits.movestogo = (int)value;
+	}
+
+	// an infinite search runs to the deepest ply until stop
+	if (infinite)
+	{
+		limits = explorer::search_limits{};
+		limits.depth = G_MAXPLY - 1;
+		limits.nodes = 0;
+	}
+	else if (!given)
+		limits = explorer::search_limits{};
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_infinite = infinite;
+		m_hold = infinite || ponder;
+		m_held = std::nullopt;
+	}
+
+	m_searching = m_position.turn;
+	m_optimizer->update_board(m_position.board);
+
+	// pondering searches the position after the ponder move, from the position before it when there is one,
+	// without limits until ponderhit engages them
+	if (ponder && m_position.previous.has_value())
+	{
+		m_optimizer->update_board(m_position.previous.value());
+		m_optimizer->ponder(checkers::state_flip(m_position.turn), m_position.last.value(), limits);
+	}
+	else if (ponder)
+		m_optimizer->ponder(m_position.turn, limits);
+	else
+		m_optimizer->start(m_position.turn, limits);
+}
+
+void uci::uci::ponderhit()
+{
+	std::optional<std::string> held;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_hold = m_infinite;
+		if (!m_hold)
+			std::swap(held, m_held);
+	}
+
+	// a ponder search that already finished reports its bestmove now
+	if (held.has_value())
+		send(held.value());
+	else
+		m_optimizer->ponderhit();
+}
+
+void uci::uci::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_hold = false;
+	}
+
+	m_optimizer->stop();
+
+	std::optional<std::string> held;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		std::swap(held, m_held);
+	}
+
+	if (held.has_value())
+		send(held.value());
+}
+
+void uci::uci::progress(const explorer::search_info &info)
+{
+	std::ostringstream line;
+	line << "info depth " << info.depth;
+
+	// the score from the perspective of the side moving
+	line << " score " << score_text(m_searching == checkers::state::RED ? info.score : -info.score);
+
+	double seconds = std::max(info.seconds, 1e-6);
+	line << " nodes " << info.nodes;
+	line << " nps " << (size_t)(info.nodes / seconds);
+	line << " time " << (size_t)(info.seconds * 1000.0);
+
+	if (!info.line.empty())
+	{
+		line << " pv";
+		for (auto &move : info.line)
+		{
+			line << " " << move.str();
+		}
+	}
+
+	send(line.str());
+}
+
+void uci::uci::finished(const explorer::search_info &info)
+{
+	// the best move is set on this thread before the callback
+	const std::optional<checkers::move> &best = m_optimizer->get_move();
+
+	std::string line = "bestmove " + (best.has_value() ? best.value().str() : std::string("none"));
+	if (best.has_value() && info.line.size() >= 2 && info.line[0] == best.value())
+		line += " ponder " + info.line[1].str();
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	if (m_hold)
+	{
+		m_held = line;
+		return;
+	}
+
+	lock.unlock();
+	send(line);
+}
+
+void uci::attach(uci &interface)
+{
+	std::string command;
+	while (interface.running() && std::getline(std::cin, command))
+	{
+		interface.handle(command);
+	}
+
+	// the end of the input quits as well
+	if (interface.running())
+		interface.handle("quit");
+}
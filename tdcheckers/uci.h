@@ -1,27 +1,108 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <memory>
+
+#include "checkers.h"
+#include "explorer.h"
 
 namespace uci
 {
+	// a position of the protocol, and the position before its last move, for pondering on that move
+	struct setup
+	{
+		checkers::board board;
+		checkers::state turn = checkers::state::RED;
+		std::optional<checkers::board> previous;
+		std::optional<checkers::move> last;
+	};
+
+	// splits the command into its whitespace separated tokens
+	std::vector<std::string> tokenize(const std::string &command);
+
+	// the text of a score from the perspective of the side moving, cp and the score in hundredths of a man, or win or loss
+	std::string score_text(float score);
+
+	// reads a position from the tokens at i, startpos or board <64 squares> <r|b>, optionally followed by moves <move>...,
+	// i is left at the first token past it, returns the error of an invalid position or an illegal move
+	std::optional<std::string> read_position(const std::vector<std::string> &tokens, size_t &i, setup &out);
+
+
 	/**
 	 * @brief Implements the universal checkers interface
+	 *
+	 * a line based protocol, one command per line, the engine keeps a single optimizer
+	 * and its transposition table across all commands
+	 *
+	 *   uci                                    identifies the engine and its options, ends with uciok
+	 *   isready                                answers readyok, also while searching
+	 *   setoption name <Hash|Threads> value <n>
+	 *   ucinewgame                             clears the transposition table
+	 *   position <startpos|board <64 squares> <r|b>> [moves <move>...]
+	 *                                          the squares as in the board string constructor, the moves as in move::str
+	 *   go [depth <n>] [nodes <n>] [movetime <ms>] [rtime <ms>] [btime <ms>] [rinc <ms>] [binc <ms>]
+	 *      [movestogo <n>] [infinite] [ponder]
+	 *                                          searches in the background, reporting info lines and a bestmove,
+	 *                                          infinite and ponder searches hold the bestmove until stop or ponderhit
+	 *   ponderhit                              the ponder move was played, the limits of the go apply from now
+	 *   stop                                   stops the search, which reports its bestmove
+	 *   quit
 	*/
 	class uci
 	{
 	public:
 		uci();
 
+		// stops the running search
+		~uci();
+
 		// handles a given command
 		void handle(const std::string &command);
 
+		// returns whether quit was not handled yet
+		bool running() const;
+
 	protected:
+		// writes a line to the output, from the input and the search threads
+		void send(const std::string &line);
 
+		// the command handlers, given the tokens after the command name
+		void identify();
+		void setoption(const std::vector<std::string> &tokens);
+		void position(const std::vector<std::string> &tokens);
+		void go(const std::vector<std::string> &tokens);
+		void ponderhit();
+		void stop();
+
+		// the callbacks of the optimizer, called on the main search thread
+		void progress(const explorer::search_info &info);
+		void finished(const explorer::search_info &info);
+
+	protected:
+		std::unique_ptr<explorer::optimizer> m_optimizer;
+
+		// the position set up
+		setup m_position;
+
+		// the side moving in the running search, the optimizer scores from the perspective of red
+		checkers::state m_searching;
+
+		// the size of the transposition table in megabytes
+		size_t m_hash;
+
+		// guards the output, and the bestmove held by infinite and ponder searches
+		std::mutex m_lock;
+		bool m_hold;
+		bool m_infinite;
+		std::optional<std::string> m_held;
+
+		bool m_running;
 	};
 
 
-	// attaches an uci interface to the stdin and stdout
+	// attaches an uci interface to the stdin and stdout, until quit or the end of the input
 	void attach(uci &interface);
 }
-
-
@@ -351,11 +351,9 @@ void gui::checkers_board::finish_game()
 {
 	m_state = { checkers::state::NONE, input_state::VIEW };
 
-	if (m_eval_initialized)
-	{
-		m_eval_initialized = false;
-		m_eval.join();
-	}
+	if (m_optimizer != nullptr)
+		m_optimizer->stop();
+	m_thinking = false;
 }
 
 glm::vec2 gui::checkers_board::screen_to_world(const glm::vec2 &screen) const
@@ -526,37 +524,34 @@ void gui::checkers_board::handle_player(
 
 void gui::checkers_board::handle_computer()
 {
-	// we start thinking now
-	m_thinking = true;
-
-	if (m_eval_initialized)
-		return;
+	// the engine keeps its search threads and transposition table between moves
+	if (m_optimizer == nullptr)
+		m_optimizer = std::make_unique<explorer::optimizer>(m_board, m_state.turn);
 
-	// initialize main thread
-	m_eval_initialized = true;
-	m_eval = std::thread([&]()
+	// start thinking, the search runs on the engine threads while the frames keep rendering
+	if (!m_thinking)
 	{
-		while (m_eval_initialized)
-		{
-			if (!m_thinking)
-				continue;
+		m_thinking = true;
 
+		checkers::state turn = m_state.turn;
+		m_optimizer->update_board(m_board);
+		m_optimizer->start(turn, explorer::search_limits{}, true);
+		return;
+	}
 
-			checkers::state turn = m_state.turn;
-			explorer::optimizer optimizer(m_board, turn);
+	if (m_optimizer->searching())
+		return;
 
-			std::optional<checkers::move> best;
-			optimizer.update_board(m_board);
-			optimizer.compute_score(turn, true);
-			best = optimizer.get_move();
+	// collect the results and play the move
+	m_optimizer->wait();
+	std::optional<checkers::move> best = m_optimizer->get_move();
+	checkers::state turn = m_state.turn;
 
-			m_boardmutex.lock();
-			m_board = m_board.perform_move(best.value(), turn);
-			m_highlights = best.value().from ^ best.value().to;
-			m_state.turn = checkers::state_flip(m_state.turn);
-			m_boardmutex.unlock();
+	m_boardmutex.lock();
+	m_board = m_board.perform_move(best.value(), turn);
+	m_highlights = best.value().from ^ best.value().to;
+	m_state.turn = checkers::state_flip(m_state.turn);
+	m_boardmutex.unlock();
 
-			m_thinking = false;
-		}
-	});
+	m_thinking = false;
 }
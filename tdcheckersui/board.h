@@ -11,6 +11,7 @@
 
 #include <mutex>
 #include <queue>
+#include <memory>
 
 namespace gui
 {
@@ -109,9 +110,8 @@ namespace gui
 
 		board_type m_type = board_type::AI_AI;
 
-		// evaluation hook
-		std::thread m_eval;
-		std::atomic<bool> m_thinking;
-		bool m_eval_initialized = false;
+		// the engine, created on its first move, and whether it is searching the current position
+		std::unique_ptr<explorer::optimizer> m_optimizer;
+		bool m_thinking = false;
 	};
 };
\ No newline at end of file